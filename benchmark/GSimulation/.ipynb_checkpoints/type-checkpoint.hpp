@@ -1 +0,0 @@
-using RealType = float;
\ No newline at end of file
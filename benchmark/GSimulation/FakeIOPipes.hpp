@@ -172,7 +172,7 @@ class ProducerImpl : public ProducerConsumerBaseImpl<Id, T, use_host_alloc> {
     event dma_event;
     if (!use_host_alloc) {
       dma_event = q.memcpy(BaseImpl::device_data_, BaseImpl::host_data_,
-                           BaseImpl::count_ * sizeof(T));
+                           count * sizeof(T));
     }
 
     // pick the right pointer to pass to the kernel
@@ -261,7 +261,7 @@ class ConsumerImpl : public ProducerConsumerBaseImpl<Id, T, use_host_alloc> {
       dma_event = q.submit([&](handler &h) {
         h.depends_on(kernel_event);
         h.memcpy(BaseImpl::host_data_, BaseImpl::device_data_,
-                 BaseImpl::count_ * sizeof(T));
+                 count * sizeof(T));
       });
     }
 
@@ -270,6 +270,241 @@ class ConsumerImpl : public ProducerConsumerBaseImpl<Id, T, use_host_alloc> {
 };
 ////////////////////////////////////////////////////////////////////////////////
 
+////////////////////////////////////////////////////////////////////////////////
+// Streaming producer/consumer implementation
+//
+// The Producer and Consumer above move one buffer per Start(). The
+// streaming versions feed a long-running kernel a sequence of batches
+// instead: the allocation is split into 'buffers' slots of 'batch'
+// elements, and every Launch() moves one batch through the next slot. The
+// launches are chained by events, so the batches go through the pipe in
+// order, and with 2 or more slots the host fills (or reads) one slot while
+// the device works on another:
+//
+//   using In = StreamProducer<InID, T, false, depth>;    // 2 buffers
+//   using Out = StreamConsumer<OutID, T, false, depth>;
+//   In::Init(q, batch);
+//   Out::Init(q, batch);
+//   T *in = In::Acquire();            // waits until the slot is free
+//   ... fill in[0..batch) ...
+//   In::Launch(q);
+//   Out::Launch(q);                   // up to 'buffers' batches ahead
+//   T *out = Out::Take();             // oldest batch, once it is back
+//
+template <typename Id, typename T, bool use_host_alloc, size_t min_capacity,
+          size_t buffers>
+class StreamImplBase : public ProducerConsumerBaseImpl<Id, T, use_host_alloc> {
+  static_assert(buffers >= 1, "need at least one buffer");
+
+ protected:
+  using BaseImpl = ProducerConsumerBaseImpl<Id, T, use_host_alloc>;
+
+  static inline size_t batch_{};
+  static inline size_t launched_{}, taken_{};
+  static inline event slot_events_[buffers];
+  static inline event last_kernel_;
+
+  // private constructor so users cannot make an object
+  StreamImplBase(){};
+
+  static size_t slot_offset(size_t n) { return (n % buffers) * batch_; }
+
+  static void count_check(size_t count) {
+    if (count > batch_) {
+      std::cerr << "ERROR: Launch() called with count=" << count
+                << " but the batch size is " << batch_ << "\n";
+      std::terminate();
+    }
+  }
+
+ public:
+  // disable copy constructor and operator=
+  StreamImplBase(const StreamImplBase &) = delete;
+  StreamImplBase &operator=(StreamImplBase const &) = delete;
+
+  static void Init(queue &q, size_t batch) {
+    BaseImpl::Init(q, batch * buffers);
+    batch_ = batch;
+    launched_ = taken_ = 0;
+    for (auto &e : slot_events_) e = event();
+    last_kernel_ = event();
+  }
+
+  // waits for every launch still in flight
+  static void Destroy(queue &q) {
+    Wait();
+    BaseImpl::Destroy(q);
+  }
+
+  static size_t BatchSize() {
+    BaseImpl::initialized_check();
+    return batch_;
+  }
+
+  static void Wait() {
+    for (auto &e : slot_events_) e.wait();
+  }
+};
+
+template <typename Id, typename T, bool use_host_alloc, size_t min_capacity,
+          size_t buffers>
+class StreamProducerImpl
+    : public StreamImplBase<Id, T, use_host_alloc, min_capacity, buffers> {
+ private:
+  using StreamBase =
+      StreamImplBase<Id, T, use_host_alloc, min_capacity, buffers>;
+  using BaseImpl = typename StreamBase::BaseImpl;
+  using kernel_ptr_type = typename BaseImpl::kernel_ptr_type;
+
+  // IDs for the pipe
+  class PipeID;
+
+  // private constructor so users cannot make an object
+  StreamProducerImpl(){};
+
+ public:
+  // disable copy constructor and operator=
+  StreamProducerImpl(const StreamProducerImpl &) = delete;
+  StreamProducerImpl &operator=(StreamProducerImpl const &) = delete;
+
+  // the pipe to connect to in device code
+  using Pipe = sycl::ext::intel::pipe<PipeID, T, min_capacity>;
+
+  // The host buffer the next Launch() sends. Waits until the launch that
+  // used this slot before is done with it
+  static T *Acquire() {
+    BaseImpl::initialized_check();
+    size_t n = StreamBase::launched_;
+    StreamBase::slot_events_[n % buffers].wait();
+    return BaseImpl::host_data_ + StreamBase::slot_offset(n);
+  }
+
+  // Send the first 'count' elements of the buffer Acquire() returned
+  static event Launch(queue &q, size_t count = StreamBase::batch_) {
+    BaseImpl::initialized_check();
+    StreamBase::count_check(count);
+
+    size_t n = StreamBase::launched_++;
+    size_t offset = StreamBase::slot_offset(n);
+
+    // If we aren't using USM host allocations, must transfer memory to device
+    event dma_event;
+    if (!use_host_alloc) {
+      dma_event = q.memcpy(BaseImpl::device_data_ + offset,
+                           BaseImpl::host_data_ + offset, count * sizeof(T));
+    }
+
+    auto kernel_ptr = BaseImpl::get_kernel_ptr() + offset;
+    event prev_kernel = StreamBase::last_kernel_;
+
+    auto kernel_event = q.submit([&](handler &h) {
+      // the batches must enter the pipe in order
+      h.depends_on({dma_event, prev_kernel});
+
+      // NO-FORMAT comments are for clang-format
+      h.single_task<Id>([=
+      ]() [[intel::kernel_args_restrict]] {  // NO-FORMAT: Attribute
+        kernel_ptr_type ptr(kernel_ptr);
+        for (size_t i = 0; i < count; i++) {
+          auto d = *(ptr + i);
+          Pipe::write(d);
+        }
+      });
+    });
+
+    StreamBase::last_kernel_ = kernel_event;
+    StreamBase::slot_events_[n % buffers] = kernel_event;
+    return kernel_event;
+  }
+};
+
+template <typename Id, typename T, bool use_host_alloc, size_t min_capacity,
+          size_t buffers>
+class StreamConsumerImpl
+    : public StreamImplBase<Id, T, use_host_alloc, min_capacity, buffers> {
+ private:
+  using StreamBase =
+      StreamImplBase<Id, T, use_host_alloc, min_capacity, buffers>;
+  using BaseImpl = typename StreamBase::BaseImpl;
+  using kernel_ptr_type = typename BaseImpl::kernel_ptr_type;
+
+  // IDs for the pipe
+  class PipeID;
+
+  // private constructor so users cannot make an object
+  StreamConsumerImpl(){};
+
+ public:
+  // disable copy constructor and operator=
+  StreamConsumerImpl(const StreamConsumerImpl &) = delete;
+  StreamConsumerImpl &operator=(StreamConsumerImpl const &) = delete;
+
+  // the pipe to connect to in device code
+  using Pipe = sycl::ext::intel::pipe<PipeID, T, min_capacity>;
+
+  // Receive the next 'count' elements into the next slot. At most
+  // 'buffers' batches can be launched and not yet taken
+  static event Launch(queue &q, size_t count = StreamBase::batch_) {
+    BaseImpl::initialized_check();
+    StreamBase::count_check(count);
+
+    if (StreamBase::launched_ - StreamBase::taken_ == buffers) {
+      std::cerr << "ERROR: Launch() called with all " << buffers
+                << " buffers in flight, Take() one first\n";
+      std::terminate();
+    }
+
+    size_t n = StreamBase::launched_++;
+    size_t offset = StreamBase::slot_offset(n);
+    auto kernel_ptr = BaseImpl::get_kernel_ptr() + offset;
+    event prev_kernel = StreamBase::last_kernel_;
+
+    auto kernel_event = q.submit([&](handler &h) {
+      // the batches must leave the pipe in order
+      h.depends_on(prev_kernel);
+
+      // NO-FORMAT comments are for clang-format
+      h.single_task<Id>([=
+      ]() [[intel::kernel_args_restrict]] {  // NO-FORMAT: Attribute
+        kernel_ptr_type ptr(kernel_ptr);
+        for (size_t i = 0; i < count; i++) {
+          auto d = Pipe::read();
+          *(ptr + i) = d;
+        }
+      });
+    });
+
+    // if the user wanted to use board memory, copy the batch back to the host
+    event done = kernel_event;
+    if (!use_host_alloc) {
+      done = q.submit([&](handler &h) {
+        h.depends_on(kernel_event);
+        h.memcpy(BaseImpl::host_data_ + offset, BaseImpl::device_data_ + offset,
+                 count * sizeof(T));
+      });
+    }
+
+    StreamBase::last_kernel_ = kernel_event;
+    StreamBase::slot_events_[n % buffers] = done;
+    return done;
+  }
+
+  // The oldest batch launched and not taken yet, once it is on the host.
+  // It stays valid until the Launch() that reuses its slot
+  static T *Take() {
+    BaseImpl::initialized_check();
+    if (StreamBase::taken_ == StreamBase::launched_) {
+      std::cerr << "ERROR: Take() called with nothing launched\n";
+      std::terminate();
+    }
+
+    size_t n = StreamBase::taken_++;
+    StreamBase::slot_events_[n % buffers].wait();
+    return BaseImpl::host_data_ + StreamBase::slot_offset(n);
+  }
+};
+////////////////////////////////////////////////////////////////////////////////
+
 }  // namespace detail
 
 // alias the implementations to face the user
@@ -292,4 +527,15 @@ using HostProducer = Producer<Id, T, true, min_capacity>;
 template <typename Id, typename T, size_t min_capacity = 0>
 using DeviceProducer = Producer<Id, T, false, min_capacity>;
 
+// N-buffered versions for a long-running kernel, double-buffered by default
+template <typename Id, typename T, bool use_host_alloc, size_t min_capacity = 0,
+          size_t buffers = 2>
+using StreamProducer =
+    detail::StreamProducerImpl<Id, T, use_host_alloc, min_capacity, buffers>;
+
+template <typename Id, typename T, bool use_host_alloc, size_t min_capacity = 0,
+          size_t buffers = 2>
+using StreamConsumer =
+    detail::StreamConsumerImpl<Id, T, use_host_alloc, min_capacity, buffers>;
+
 #endif /* __FAKEIOPIPES_HPP__ */
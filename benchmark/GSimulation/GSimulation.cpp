@@ -5,16 +5,95 @@
 // =============================================================
 
 #include "GSimulation.hpp"
+#include "ParticleLayout.hpp"
+#include "ParticleTiles.hpp"
+#include "MutationBatch.hpp"
+#include "HostSideChannel.hpp"
 
 // dpc_common.hpp can be found in the dev-utilities include folder.
 // e.g., $ONEAPI_ROOT/dev-utilities/latest/include/dpc_common.hpp
 #include "dpc_common.hpp"
+#include "../common/ForkServer.hpp"
+#include "../common/HarnessPolicy.hpp"
+#include "../common/InputReader.hpp"
+#include "../common/Metrics.hpp"
+#include "../common/Random.hpp"
+#include "../common/DeviceCoverage.hpp"
+#include "../common/AsyncWriter.hpp"
+#include "../common/KernelVariants.hpp"
 #if FPGA || FPGA_EMULATOR
   #include <sycl/ext/intel/fpga_extensions.hpp>
 #endif
+#include <math.h>
+#include <stdlib.h>
 
 using namespace sycl;
 
+// What this build compiles in, see HarnessPolicy.hpp. For GSimulation:
+//  - probes 1: distance_sqr and acc extremes, and the force kernel's device
+//    coverage; probes 2 adds the dx/dy/dz extremes; probes 0 is the plain
+//    simulation, with nothing but the energy reduced;
+//  - mutation: kVariants mutated copies of the system per test case (see
+//    MutationBatch.hpp), otherwise one unmutated copy;
+//  - side channel: the update kernel sends every work-item's |acc| to the
+//    host through a DeviceToHostStream instead of reducing the acc extremes
+//    on the device.
+using Harness = hfuzz::BuildPolicy;
+
+// Copies of the system a test case runs side by side
+constexpr int kCopies = Harness::kMutation ? kVariants : 1;
+
+// Test cases a persistent child runs before it is replaced by a fresh fork
+constexpr unsigned kPersistentCount = 1000;
+
+// Probe ids of the values reported to the fuzzer through hfuzz::Metrics
+enum { kProbeDx, kProbeDy, kProbeDz, kProbeDistanceSqr, kProbeAcc };
+
+// Per-work-item |acc| of the update kernel, with the side channel
+struct AccChannelID;
+using AccChannel = DeviceToHostStream<AccChannelID, RealType>;
+
+// What the update kernel captures instead when the side channel is compiled
+// out
+struct NoAccChannel {
+  bool write(uint32_t, const RealType &) const { return false; }
+};
+
+// Work-group and tile sizes of the force kernel. The fuzzer picks one per
+// test case (hetero-fuzz -V 5), the build's own comes first and is the one
+// run without a pick. n must be a multiple of every work-group size
+using ForceVariants = hfuzz::KernelVariants<
+    hfuzz::KernelConfig<1, kWorkGroup, kTile>,
+    hfuzz::KernelConfig<1, kWorkGroup, 0>,
+    hfuzz::KernelConfig<1, 64, 64>,
+    hfuzz::KernelConfig<1, 64, 256>,
+    hfuzz::KernelConfig<1, 32, 32>>;
+
+// One line of the energy table; the writer thread formats it
+struct StepRow {
+  int step;
+  double time, energy, elapsed, gflops;
+};
+
+// Device time of a finished kernel, in seconds; the queue profiles
+static double KernelSeconds(const event &e) {
+  return (e.get_profiling_info<info::event_profiling::command_end>() -
+          e.get_profiling_info<info::event_profiling::command_start>()) *
+         1e-9;
+}
+
+static void FormatRow(std::string &out, const StepRow &r) {
+  std::ostringstream os;
+  os << " " << std::left << std::setw(8) << r.step << std::left
+     << std::setprecision(5) << std::setw(8) << r.time
+     << std::left << std::setprecision(5) << std::setw(12)
+     << r.energy << std::left << std::setprecision(5)
+     << std::setw(12) << r.elapsed << std::left
+     << std::setprecision(5) << std::setw(12)
+     << r.gflops << "\n";
+  out += os.str();
+}
+
     // Create device selector for the device of your interest.
 #if FPGA_EMULATOR
   // DPC++ extension: FPGA emulator selector on systems without FPGA card.
@@ -50,12 +129,12 @@ void GSimulation::SetNumberOfSteps(int N) { set_nsteps(N); }
 /* Initialize the position of all the particles using random number generator
  * between 0 and 1.0 */
 void GSimulation::InitPos(std::string file) {
-  
-  std::ifstream read(file);
+
+  hfuzz::InputReader read(file);
   if (!read.is_open()){
       std::cout << "Could not open the input file.\n";
-  } 
-    
+  }
+
   std::random_device rd;  // random number generator
   std::mt19937 gen(42);
   std::uniform_real_distribution<RealType> unif_d(0, 1.0);
@@ -113,147 +192,330 @@ void GSimulation::InitMass() {
   }
 }
 
+void mutate(ParticleRef a, int knob, float value){
+    if (knob==1){
+        a.pos[0] = value;
+        a.pos[1] = value;
+        a.pos[2] = value;
+    }
+    else if (knob==2){
+        a.pos[0] = 0;
+        a.pos[1] = 0;
+        a.pos[2] = 0;
+    }
+    else if (knob==3){
+        a.pos[0] = a.pos[0] * 100000;
+    }
+    else if (knob==4){
+        a.pos[0] = a.pos[0]/ 100 - 100000;
+    }
+}
+
 /* This function does the simulation logic for Nbody */
 void GSimulation::Start(std::string file) {
   RealType dt = get_tstep();
   int n = get_npart();
-  particles_.resize(n);
-  
-
-  InitPos(file);
-  InitVel();
-  InitAcc();
-  InitMass();
-
-  PrintHeader();
-
-  total_time_ = 0.;
 
   constexpr float kSofteningSquared = 1e-14f;
   // prevents explosion in the case the particles are really close to each other
   constexpr float kG = 6.67259e-11f;
-  double gflops = 1e-9 * ((11. + 18.) * n * n + n * 19.);
-  int nf = 0;
-  double av = 0.0, dev = 0.0;
+  // Every step advances kCopies copies of the system
+  double gflops = kCopies * 1e-9 * ((11. + 18.) * n * n + n * 19.);
   // Create global range
-  auto r = range<1>(n);
+  auto r = range<1>(kCopies * n);
   // Create local range
-  auto lr = range<1>(128);
-  // Create ndrange 
+  auto lr = range<1>(kWorkGroup);
+  // Create ndrange
   auto ndrange = nd_range<1>(r, lr);
   // Create a queue to the selected device and enabled asynchronous exception
   // handling for that queue
-  queue q(d_selector, dpc_common::exception_handler);
-  // Create SYCL buffer for the Particle array of size "n"
-  buffer pbuf(particles_.data(), r,
-              {cl::sycl::property::buffer::use_host_ptr()});
-  // Allocate energy using USM allocator shared
-  RealType *energy = malloc_shared<RealType>(1,q);
-  *energy = 0.f;
-  
-
-  dpc_common::TimeInterval t0;
-  int nsteps = get_nsteps();
-  // Looping across integration steps
-  for (int s = 1; s <= nsteps; ++s) {
-    dpc_common::TimeInterval ts0;
-    // Submitting first kernel to device which computes acceleration of all
-    // particles
-    q.submit([&](handler& h) {
-       auto p = pbuf.get_access(h);
-       h.parallel_for(ndrange, [=](nd_item<1> it) {
-	 auto i = it.get_global_id();
-         RealType acc0 = p[i].acc[0];
-         RealType acc1 = p[i].acc[1];
-         RealType acc2 = p[i].acc[2];
-         for (int j = 0; j < n; j++) {
-           RealType dx, dy, dz;
-           RealType distance_sqr = 0.0f;
-           RealType distance_inv = 0.0f;
-
-           dx = p[j].pos[0] - p[i].pos[0];  // 1flop
-           dy = p[j].pos[1] - p[i].pos[1];  // 1flop
-           dz = p[j].pos[2] - p[i].pos[2];  // 1flop
-
-           distance_sqr =
-               dx * dx + dy * dy + dz * dz+ kSofteningSquared;  // 6flops
-           distance_inv = 1.0f / sycl::sqrt(distance_sqr);       // 1div+1sqrt
-
-           if (dx==0) {acc0=0;}
-           else{
-             acc0 += dx * kG * p[j].mass * distance_inv * distance_inv *
-                   distance_inv; } // 6flops
-           if (dy==0) {acc1=0;}
-           else{
-           acc1 += dy * kG * p[j].mass * distance_inv * distance_inv *
-                   distance_inv; } // 6flops}
-           if (dz==0){acc2=0;}
-           else{
-           acc2 += dz * kG * p[j].mass * distance_inv * distance_inv *
-                   distance_inv;}  // 6flops
-          }
-         //p[i].acc[0] = acc0;
-         //p[i].acc[1] = acc1;
-         //p[i].acc[2] = acc2;
-           
-         p[i].vel[0] += acc0 * dt;  // 2flops
-         p[i].vel[1] += acc1 * dt;  // 2flops
-         p[i].vel[2] += acc2 * dt;  // 2flops
-       });
-     }).wait_and_throw();
-    // Second kernel updates the velocity and position for all particles
-    q.submit([&](handler& h) {
-       auto p = pbuf.get_access(h);
-       #if(__SYCL_COMPILER_VERSION <= 20200827)
-       h.parallel_for(ndrange, intel::reduction(energy, 0.f, std::plus<RealType>()), [=](nd_item<1> it, auto& energy) {
-       #else
-       h.parallel_for(ndrange, ext::oneapi::reduction(energy, 0.f, std::plus<RealType>()), [=](nd_item<1> it, auto& energy) {
-       #endif
-	 auto i = it.get_global_id();
-
-         p[i].pos[0] += p[i].vel[0] * dt;  // 2flops
-         p[i].pos[1] += p[i].vel[1] * dt;  // 2flops
-         p[i].pos[2] += p[i].vel[2] * dt;  // 2flops
-
-         p[i].acc[0] = 0.f;
-         p[i].acc[1] = 0.f;
-         p[i].acc[2] = 0.f;
-
-         energy += (p[i].mass *
-                (p[i].vel[0] * p[i].vel[0] + p[i].vel[1] * p[i].vel[1] +
-                 p[i].vel[2] * p[i].vel[2]));  // 7flops
+  queue q(d_selector, dpc_common::exception_handler,
+          ParticleBuffer::QueueProperties());
+  // Create SYCL buffer for the Particle array of size "n". The runtime owns
+  // its storage so that it can outlive a single test case.
+  particles_.resize(n);
+  ParticleBuffer pbuf(q, kCopies * n);
+  // Per-copy mutations and the step values the kernels reduce, see
+  // kStat*; USM shared so the host writes and reads them in place. Steps
+  // alternate between two sets of stats, so the host can read one step's
+  // while the next one runs
+  MutationDesc *descs = malloc_shared<MutationDesc>(kCopies, q);
+  RealType *stats = malloc_shared<RealType>(2 * kCopies * kStats, q);
+  // Branch coverage of the force kernel goes to the fuzzer's map
+  if constexpr (Harness::kProbes >= 1) hfuzz::DeviceCoverage::Init(q);
+  // Two steps' worth of records can be in the ring at a time
+  if constexpr (Harness::kSideChannel) AccChannel::Init(q, 2 * kCopies * n);
+
+  // Queue, buffer and compiled kernels stay alive across test cases: the
+  // first pass starts the fork server, every iteration runs one input
+  while (hfuzz::PersistentLoop(kPersistentCount)) {
+    InitPos(file);
+    InitVel();
+    InitAcc();
+    InitMass();
+
+    PrintHeader();
+
+    total_time_ = 0.;
+    int nf = 0;
+    double av = 0.0, dev = 0.0;
+    // Upload the initial state of this test case, once per copy
+    pbuf.Upload(q, particles_, kCopies);
+
+    float acc_max = 0;
+    float acc_min = 0;
+    // The table goes out in one batch at the end of the test case
+    hfuzz::AsyncWriter<StepRow> rows(FormatRow);
+    dpc_common::TimeInterval t0;
+    double t_last = 0.0;
+    int nsteps = get_nsteps();
+    // Every mutation choice below derives from the fuzzer's seed, which
+    // the fuzzer keeps in its replay log; without one, use the clock
+    uint64_t seed = hfuzz::Metrics::Seed();
+    if (!seed) seed = time(NULL);
+    if constexpr (Harness::kMutation)
+      std::cout << "Mutation seed: " << seed << "\n";
+    int variant = hfuzz::Metrics::Variant();
+    if (variant) variant--;
+    std::cout << "Force kernel variant: " << variant << "\n";
+    hfuzz::Rng rng(seed);
+    // Host side of step s once its update kernel is done. A step's time
+    // runs from the previous step's results to its own, so the times add
+    // up to the run even though steps overlap
+    auto finish_step = [&](int s, const RealType *step_stats) {
+      // The table follows the first copy
+      kenergy_ = 0.5 * step_stats[kStatEnergy];
+      double now = t0.Elapsed();
+      double elapsed_seconds = now - t_last;
+      t_last = now;
+      if ((s % get_sfreq()) == 0) {
+        nf += 1;
+        rows.Push({s, s * get_tstep(), kenergy_, elapsed_seconds,
+                   gflops * get_sfreq() / elapsed_seconds});
+        if (nf > 2) {
+          av += gflops * get_sfreq() / elapsed_seconds;
+          dev += gflops * get_sfreq() * gflops * get_sfreq() /
+                 (elapsed_seconds * elapsed_seconds);
+        }
+      }
+
+      if constexpr (Harness::kSideChannel) {
+        // Whatever the update kernels have published so far; the running
+        // maximum does not care which step a record belongs to
+        AccChannel::Drain([&](uint32_t, RealType acpt) {
+          if (acpt>acc_max) {acc_max=acpt;}
+        });
+      } else if constexpr (Harness::kProbes >= 1) {
+        for (int v = 0; v < kCopies; v++) {
+          const RealType *st = step_stats + v * kStats;
+          if (st[kStatAccMax]>acc_max) {acc_max=st[kStatAccMax];}
+          if (st[kStatAccMin]<acc_min) {acc_min=st[kStatAccMin];}
+        }
+        if (-acc_min>acc_max) {acc_max = -acc_min;}
+      }
+      if constexpr (Harness::kProbes >= 1)
+        hfuzz::Metrics::Probe(kProbeAcc, acc_max);
+      hfuzz::Metrics::Step(elapsed_seconds, acc_max);
+    };
+    event mutation, update;
+    // Device time of the step kernels, collected as they finish
+    double kernel_time = 0.0;
+    // Looping across integration steps. The kernels of a step are chained
+    // by events; the host waits for the force kernel only, and finishes the
+    // previous step while this step's update runs
+    for (int s = 1; s <= nsteps; ++s) {
+      event prev_update = update;
+      RealType *step_stats = stats + (s % 2) * kCopies * kStats;
+      ResetStats(step_stats, kCopies);
+      if constexpr (Harness::kMutation) {
+        // The fuzzer schedules the device knobs; every copy picks one
+        // itself when it did not
+        PlanMutations(rng, hfuzz::Metrics::Knob(), n, descs);
+        mutation = q.submit([&](handler& h) {
+            auto p = pbuf.get_access(h);
+            h.parallel_for(range<1>(kCopies * n), [=](id<1> g) {
+                int v = g[0] / n, i = g[0] % n;
+                const MutationDesc &d = descs[v];
+                if (i < d.start || i >= d.end) return;
+                // One stream per work-item: every particle gets its own value
+                hfuzz::Rng item_rng(d.seed, i);
+                mutate(p[g[0]], d.knob, d.value * item_rng.Uniform());
+            });
+        });
+      }
+      // Submitting first kernel to device which computes acceleration of all
+      // particles, and the extremes of dx/dy/dz/distance_sqr over all pairs,
+      // for every copy
+      event force;
+      ForceVariants::Run(variant, [&](auto cfg) {
+        using Config = decltype(cfg);
+        force = q.submit([&](handler& h) {
+           if constexpr (Harness::kMutation) h.depends_on(mutation);
+           auto p = pbuf.get_access(h);
+           ParticleTiles<Config::kWorkGroup, Config::kTile> tiles(h);
+           auto cov = hfuzz::DeviceCoverage::AttachIf<(Harness::kProbes >= 1)>(h);
+           h.parallel_for(nd_range<1>(r, range<1>(Config::kWorkGroup)),
+                          [=](nd_item<1> it) {
+             size_t i = it.get_global_id(0), v = kCopies > 1 ? i / n : 0;
+             cov.Begin(it);
+               RealType dx, dy, dz;
+               RealType dxmax = kLowest, dxmin = kHighest;
+               RealType dymax = kLowest, dymin = kHighest;
+               RealType dzmax = kLowest, dzmin = kHighest;
+               RealType distance_sqr = 0.0f;
+               RealType distance_sqrmax = kLowest, distance_sqrmin = kHighest;
+               // The same force law in every policy, so that the probes are
+               // the only difference between builds
+               RealType acc0 = 0, acc1 = 0, acc2 = 0;
+             tiles.ForEach(it, p, v * n, n, [&](int j, const float4 &pj) {
+               // #pragma HLS unroll factor=2
+               RealType distance_inv = 0.0f;
+
+               dx = pj[0] - p[i].pos[0];  // 1flop
+               dy = pj[1] - p[i].pos[1];  // 1flop
+               dz = pj[2] - p[i].pos[2];  // 1flop
+               if constexpr (Harness::kProbes >= 2) {
+                 if (HFUZZ_COV(cov, dx>dxmax)) {dxmax=dx;}
+                 if (HFUZZ_COV(cov, dx<dxmin)) {dxmin=dx;}
+                 if (HFUZZ_COV(cov, dy>dymax)) {dymax=dy;}
+                 if (HFUZZ_COV(cov, dy<dymin)) {dymin=dy;}
+                 if (HFUZZ_COV(cov, dz>dzmax)) {dzmax=dz;}
+                 if (HFUZZ_COV(cov, dz<dzmin)) {dzmin=dz;}
+               }
+
+               distance_sqr =
+                   dx * dx + dy * dy + dz * dz+ kSofteningSquared;  // 6flops
+               if constexpr (Harness::kProbes >= 1) {
+                 if (HFUZZ_COV(cov, distance_sqr>distance_sqrmax)) {distance_sqrmax=distance_sqr;}
+                 if (HFUZZ_COV(cov, distance_sqr<distance_sqrmin)) {distance_sqrmin=distance_sqr;}
+               }
+               distance_inv = 1.0f / sycl::sqrt(distance_sqr);       // 1div+1sqrt
+               acc0 += dx * kG * pj[3] * distance_inv * distance_inv *
+                       distance_inv;  // 6flops
+               acc1 += dy * kG * pj[3] * distance_inv * distance_inv *
+                       distance_inv;  // 6flops
+               acc2 += dz * kG * pj[3] * distance_inv * distance_inv *
+                       distance_inv;  // 6flops
+             });
+
+             p[i].acc[0] = acc0;
+             p[i].acc[1] = acc1;
+             p[i].acc[2] = acc2;
+
+             p[i].vel[0] += acc0 * dt;  // 2flops
+             p[i].vel[1] += acc1 * dt;  // 2flops
+             p[i].vel[2] += acc2 * dt;  // 2flops
+             // A work-group never spans two copies
+             RealType *st = step_stats + v * kStats;
+             if constexpr (Harness::kProbes >= 2) {
+               GroupMax(it, st[kStatDxMax], dxmax);
+               GroupMin(it, st[kStatDxMin], dxmin);
+               GroupMax(it, st[kStatDyMax], dymax);
+               GroupMin(it, st[kStatDyMin], dymin);
+               GroupMax(it, st[kStatDzMax], dzmax);
+               GroupMin(it, st[kStatDzMin], dzmin);
+             }
+             if constexpr (Harness::kProbes >= 1) {
+               GroupMax(it, st[kStatDistanceSqrMax], distance_sqrmax);
+               GroupMin(it, st[kStatDistanceSqrMin], distance_sqrmin);
+             }
+             cov.End(it);
+           });
+         });
+      });
+      // Second kernel updates the velocity and position for all particles,
+      // and reduces the kinetic energy and the extremes of acc per copy
+      update = q.submit([&](handler& h) {
+         h.depends_on(force);
+         auto p = pbuf.get_access(h);
+         auto ch = [] {
+           if constexpr (Harness::kSideChannel) return AccChannel::Attach();
+           else return NoAccChannel{};
+         }();
+         h.parallel_for(ndrange, [=](nd_item<1> it) {
+  	    size_t i = it.get_global_id(0), v = kCopies > 1 ? i / n : 0;
+
+           p[i].pos[0] += p[i].vel[0] * dt;  // 2flops
+          p[i].pos[1] += p[i].vel[1] * dt;  // 2flops
+           p[i].pos[2] += p[i].vel[2] * dt;  // 2flops
+
+           RealType energy = (p[i].mass *
+                  (p[i].vel[0] * p[i].vel[0] + p[i].vel[1] * p[i].vel[1] +
+                   p[i].vel[2] * p[i].vel[2]));  // 7flops
+           RealType *st = step_stats + v * kStats;
+           GroupSum(it, st[kStatEnergy], energy);
+           if constexpr (Harness::kSideChannel) {
+             ch.write(kProbeAcc,
+                      sycl::max(sycl::max(sycl::fabs(p[i].acc[0]),
+                                          sycl::fabs(p[i].acc[1])),
+                                sycl::fabs(p[i].acc[2])));
+           } else if constexpr (Harness::kProbes >= 1) {
+             GroupMax(it, st[kStatAccMax],
+                      sycl::max(sycl::max(p[i].acc[0], p[i].acc[1]),
+                                p[i].acc[2]));
+             GroupMin(it, st[kStatAccMin],
+                      sycl::min(sycl::min(p[i].acc[0], p[i].acc[1]),
+                                p[i].acc[2]));
+           }
+         });
        });
-     }).wait_and_throw();
-    kenergy_ = 0.5 * (*energy);
-    *energy = 0.f;
-    double elapsed_seconds = ts0.Elapsed();
-    if ((s % get_sfreq()) == 0) {
-      nf += 1;
-      std::cout << " " << std::left << std::setw(8) << s << std::left
-                << std::setprecision(5) << std::setw(8) << s * get_tstep()
-                << std::left << std::setprecision(5) << std::setw(12)
-                << kenergy_ << std::left << std::setprecision(5)
-                << std::setw(12) << elapsed_seconds << std::left
-                << std::setprecision(5) << std::setw(12)
-                << gflops * get_sfreq() / elapsed_seconds << "\n";
-      if (nf > 2) {
-        av += gflops * get_sfreq() / elapsed_seconds;
-        dev += gflops * get_sfreq() * gflops * get_sfreq() /
-               (elapsed_seconds * elapsed_seconds);
+
+      force.wait_and_throw();
+      kernel_time += KernelSeconds(force);
+      if constexpr (Harness::kMutation) kernel_time += KernelSeconds(mutation);
+      if (s > 1) kernel_time += KernelSeconds(prev_update);
+      if constexpr (Harness::kProbes >= 1) {
+        hfuzz::DeviceCoverage::Merge();
+
+        // The fuzzer sees the extremes over all copies of the test case
+        for (int v = 0; v < kCopies; v++) {
+          const RealType *st = step_stats + v * kStats;
+          if constexpr (Harness::kProbes >= 2) {
+            hfuzz::Metrics::Probe(kProbeDx, st[kStatDxMax]);
+            hfuzz::Metrics::Probe(kProbeDx, st[kStatDxMin]);
+            hfuzz::Metrics::Probe(kProbeDy, st[kStatDyMax]);
+            hfuzz::Metrics::Probe(kProbeDy, st[kStatDyMin]);
+            hfuzz::Metrics::Probe(kProbeDz, st[kStatDzMax]);
+            hfuzz::Metrics::Probe(kProbeDz, st[kStatDzMin]);
+          }
+          hfuzz::Metrics::Probe(kProbeDistanceSqr, st[kStatDistanceSqrMax]);
+          hfuzz::Metrics::Probe(kProbeDistanceSqr, st[kStatDistanceSqrMin]);
+        }
       }
-    }
 
-  }  // end of the time step loop
-  total_time_ = t0.Elapsed();
-  total_flops_ = gflops * get_nsteps();
-  av /= (double)(nf - 2);
-  dev = sqrt(dev / (double)(nf - 2) - av * av);
+      // Step s-1's update finished before this force kernel started
+      if (s > 1)
+        finish_step(s - 1, stats + ((s - 1) % 2) * kCopies * kStats);
+    }  // end of the step loop
+    update.wait_and_throw();
+    if (nsteps > 0) kernel_time += KernelSeconds(update);
+    if constexpr (Harness::kSideChannel)
+      AccChannel::Flush([&](uint32_t, RealType acpt) {
+        if (acpt>acc_max) {acc_max=acpt;}
+      });
+    if (nsteps > 0)
+      finish_step(nsteps, stats + (nsteps % 2) * kCopies * kStats);
+    rows.Finish(std::cout);
 
-  std::cout <<"\n";
-  std::cout << "# Total Time (s)     : " << total_time_ << "\n";
-  std::cout << "# Average Performance : " << av << " +- " << dev << "\n";
-  std::cout << "==============================="
-            << "\n";
+    total_time_ = t0.Elapsed();
+    total_flops_ = gflops * get_nsteps();
+    av /= (double)(nf - 2);
+    dev = sqrt(dev / (double)(nf - 2) - av * av);
+    std::cout <<"\n";
+    std::cout << "# Total Time (s)     : " << total_time_ << "\n";
+    std::cout << "# Average Performance : " << av << " +- " << dev << "\n";
+    std::cout << "==============================="
+              << "\n";
+    hfuzz::Metrics::SetExecTime(total_time_);
+    hfuzz::Metrics::SetGFLOPS(av);
+    hfuzz::Metrics::SetKernelTime(kernel_time);
+    hfuzz::Metrics::Flush();
+  }
+
+  if constexpr (Harness::kSideChannel) AccChannel::Destroy(q);
+  if constexpr (Harness::kProbes >= 1) hfuzz::DeviceCoverage::Destroy(q);
+  free(stats, q);
+  free(descs, q);
 }
 
 /* Print the headers for the output */
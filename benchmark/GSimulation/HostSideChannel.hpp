@@ -1,6 +1,8 @@
 #ifndef __HOSTSIDECHANNEL_HPP__
 #define __HOSTSIDECHANNEL_HPP__
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <type_traits>
 
@@ -147,4 +149,161 @@ public:
   }
 };
 
+//
+// A batched device-to-host side channel for values that many work-items
+// report, e.g. per-work-item probe values.
+//
+// DeviceToHostSideChannel moves one value per consumer kernel launch. This
+// one is a ring of records in USM host memory, set up once per run: kernels
+// append (tag, value) records through a Writer they capture by value, and
+// the host reads them straight out of the ring, without a kernel launch or
+// DMA, while the next kernel may already be running:
+//
+//   using Probes = DeviceToHostStream<ProbesID, float>;
+//   Probes::Init(q, 1 << 16);              // once
+//   q.submit([&](handler &h) {
+//     auto ch = Probes::Attach();
+//     h.parallel_for(..., [=](...) { ch.write(kProbeAcc, acc); });
+//   }).wait();
+//   Probes::Flush([&](uint32_t tag, float v) { ... });
+//
+// Drain() takes what is published so far and never waits, so it can run
+// next to a kernel that is still writing; Flush() is for when the writers
+// have finished. A write that finds the ring full is dropped and counted in
+// Lost(), without taking a slot, so the writes after it go through as soon
+// as the host drains; the capacity (rounded up to a power of two) should
+// cover what is written between two drains.
+//
+template <typename Id, typename T>
+class DeviceToHostStream {
+public:
+  struct Record {
+    uint32_t seq;  // slot + 1 once tag and value are written
+    uint32_t tag;
+    T value;
+  };
+
+  // Per-kernel handle, captured by value by the kernel lambda
+  struct Writer {
+    Record *ring;
+    uint32_t *ctl;
+    uint32_t mask;
+
+    // DEVICE CODE
+    // Reserves a slot only if there is room: a slot taken and never
+    // published would stop Drain() for good
+    bool write(uint32_t tag, const T &value) const {
+      uint32_t slot = Ref(ctl[kHead]).load();
+      do {
+        if (slot - Ref(ctl[kTail]).load() > mask) {
+          Ref(ctl[kLost]).fetch_add(1);
+          return false;
+        }
+      } while (!Ref(ctl[kHead]).compare_exchange_weak(slot, slot + 1));
+      Record &r = ring[slot & mask];
+      r.tag = tag;
+      r.value = value;
+      Ref(r.seq).store(slot + 1, memory_order::release);
+      return true;
+    }
+  };
+
+  // disable copy constructor and operator=
+  DeviceToHostStream()=delete;
+  DeviceToHostStream(const DeviceToHostStream &)=delete;
+  DeviceToHostStream& operator=(DeviceToHostStream const &)=delete;
+
+  static void Init(queue &q, size_t capacity) {
+    if (!q.get_device().get_info<info::device::usm_host_allocations>()) {
+      std::cerr << "ERROR: The selected device does not support USM host"
+                << " allocations\n";
+      std::terminate();
+    }
+
+    size_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    mask_ = cap - 1;
+    ring_ = malloc_host<Record>(cap, q);
+    ctl_ = malloc_host<uint32_t>(kCtlWords, q);
+    if (!ring_ || !ctl_) {
+      std::cerr << "ERROR: failed to allocate the side channel ring\n";
+      std::terminate();
+    }
+    memset(ring_, 0, cap * sizeof(Record));
+    memset(ctl_, 0, kCtlWords * sizeof(uint32_t));
+    tail_ = 0;
+  }
+
+  static void Destroy(queue &q) {
+    sycl::free(ring_, q);
+    sycl::free(ctl_, q);
+    ring_ = nullptr;
+    ctl_ = nullptr;
+  }
+
+  static Writer Attach() { return Writer{ring_, ctl_, mask_}; }
+
+  // HOST CODE
+  // Hands the records published so far, in order, to f(tag, value) and
+  // returns how many. Stops at the first slot whose writer is not done yet.
+  template <typename F>
+  static size_t Drain(F &&f) {
+    size_t cnt = 0;
+    for (;; tail_++, cnt++) {
+      Record &r = ring_[tail_ & mask_];
+      if (__atomic_load_n(&r.seq, __ATOMIC_ACQUIRE) != tail_ + 1) break;
+      f(r.tag, r.value);
+    }
+    __atomic_store_n(&ctl_[kTail], tail_, __ATOMIC_RELEASE);
+    return cnt;
+  }
+
+  // HOST CODE
+  // Copies up to out.size() published records into out, returns how many
+  static size_t read(span<Record> out) {
+    size_t cnt = 0;
+    for (; cnt < out.size(); tail_++, cnt++) {
+      Record &r = ring_[tail_ & mask_];
+      if (__atomic_load_n(&r.seq, __ATOMIC_ACQUIRE) != tail_ + 1) break;
+      out[cnt] = r;
+    }
+    __atomic_store_n(&ctl_[kTail], tail_, __ATOMIC_RELEASE);
+    return cnt;
+  }
+
+  // HOST CODE
+  // Like Drain(), once every kernel that writes has finished: takes
+  // everything up to the head, so the ring is empty afterwards
+  template <typename F>
+  static size_t Flush(F &&f) {
+    uint32_t head = __atomic_load_n(&ctl_[kHead], __ATOMIC_ACQUIRE);
+    size_t cnt = 0;
+    for (; tail_ != head; tail_++) {
+      Record &r = ring_[tail_ & mask_];
+      if (__atomic_load_n(&r.seq, __ATOMIC_ACQUIRE) != tail_ + 1) continue;
+      f(r.tag, r.value);
+      cnt++;
+    }
+    __atomic_store_n(&ctl_[kTail], tail_, __ATOMIC_RELEASE);
+    return cnt;
+  }
+
+  // Writes dropped because the ring was full, since Init()
+  static uint32_t Lost() {
+    return __atomic_load_n(&ctl_[kLost], __ATOMIC_RELAXED);
+  }
+
+protected:
+  enum { kHead, kTail, kLost, kCtlWords };
+
+  // the host reads the ring while kernels write it
+  using Ref = atomic_ref<uint32_t, memory_order::relaxed, memory_scope::system,
+                         access::address_space::global_space>;
+
+  static inline Record *ring_{nullptr};
+  static inline uint32_t *ctl_{nullptr};
+  static inline uint32_t mask_{0};
+  static inline uint32_t tail_{0};  // host only; published in ctl_[kTail]
+};
+
 #endif /* __HOSTSIDECHANNEL_HPP__ */
@@ -14,9 +14,17 @@
 
 using namespace sycl;
 
-// declare the kernel and pipe ID stucts globally to reduce name mangling
-struct LoopBackMainKernel;
+// declare the kernel and pipe ID stucts globally to reduce name mangling.
+// They are templated on the configuration of the system, so that one
+// program can run several (see PipeBench.cpp)
+template <typename T, bool use_usm_host_alloc, size_t io_pipe_depth,
+          size_t buffers>
+struct LoopbackConfig {};
+
+template <typename Config> struct LoopBackMainKernel;
+template <typename Config>
 struct LoopBackReadIOPipeID { static constexpr unsigned id = 0; };
+template <typename Config>
 struct LoopBackWriteIOPipeID { static constexpr unsigned id = 1; };
 
 
@@ -28,9 +36,9 @@ struct LoopBackWriteIOPipeID { static constexpr unsigned id = 1; };
 // stitching together the whole system. In this tutorial, the stitching of the
 // full system is done below in the 'RunLoopbackSystem' function.
 //
-template<class IOPipeIn, class IOPipeOut>
+template<class Config, class IOPipeIn, class IOPipeOut>
 event SubmitLoopbackKernel(queue& q, size_t count) {
-  return q.single_task<LoopBackMainKernel>([=] {
+  return q.single_task<LoopBackMainKernel<Config>>([=] {
     for (size_t i = 0; i < count; i++) {
       auto data = IOPipeIn::read();
       // !!! Your processing can go here !!!
@@ -42,18 +50,18 @@ event SubmitLoopbackKernel(queue& q, size_t count) {
 //
 // Run the loopback system
 //
-template<typename T, bool use_usm_host_alloc>
+template<typename T, bool use_usm_host_alloc, size_t kIOPipeDepth = 4>
 bool RunLoopbackSystem(queue& q, size_t count) {
   bool passed = true;
+  using Config = LoopbackConfig<T, use_usm_host_alloc, kIOPipeDepth, 0>;
 
   //////////////////////////////////////////////////////////////////////////////
   // IO pipes
-  constexpr size_t kIOPipeDepth = 4;
 #ifndef USE_REAL_IO_PIPES
   // these are FAKE IO pipes (and their producer/consumer)
-  using FakeIOPipeInProducer = Producer<LoopBackReadIOPipeID,
+  using FakeIOPipeInProducer = Producer<LoopBackReadIOPipeID<Config>,
                                 T, use_usm_host_alloc, kIOPipeDepth>;
-  using FakeIOPipeOutConsumer = Consumer<LoopBackWriteIOPipeID,
+  using FakeIOPipeOutConsumer = Consumer<LoopBackWriteIOPipeID<Config>,
                                  T, use_usm_host_alloc, kIOPipeDepth>;
   using ReadIOPipe = typename FakeIOPipeInProducer::Pipe;
   using WriteIOPipe = typename FakeIOPipeOutConsumer::Pipe;
@@ -64,10 +72,10 @@ bool RunLoopbackSystem(queue& q, size_t count) {
 #else
   // these are REAL IO pipes
   using ReadIOPipe = 
-    ext::intel::kernel_readable_io_pipe<LoopBackReadIOPipeID,
+    ext::intel::kernel_readable_io_pipe<LoopBackReadIOPipeID<Config>,
                                    T, kIOPipeDepth>;
   using WriteIOPipe =
-    ext::intel::kernel_writeable_io_pipe<LoopBackWriteIOPipeID,
+    ext::intel::kernel_writeable_io_pipe<LoopBackWriteIOPipeID<Config>,
                                     T, kIOPipeDepth>;
 #endif
   //////////////////////////////////////////////////////////////////////////////
@@ -82,7 +90,8 @@ bool RunLoopbackSystem(queue& q, size_t count) {
 #endif
 
   // submit the main processing kernel
-  auto kernel_event = SubmitLoopbackKernel<ReadIOPipe, WriteIOPipe>(q, count);
+  auto kernel_event =
+      SubmitLoopbackKernel<Config, ReadIOPipe, WriteIOPipe>(q, count);
 
   // FAKE IO PIPES ONLY
 #ifndef USE_REAL_IO_PIPES
@@ -121,6 +130,94 @@ bool RunLoopbackSystem(queue& q, size_t count) {
       passed &= false;
     }
   }
+
+  FakeIOPipeInProducer::Destroy(q);
+  FakeIOPipeOutConsumer::Destroy(q);
+#endif
+
+  return passed;
+}
+
+//
+// Run the loopback system as a stream: one launch of the processing kernel
+// takes 'batches' batches of 'batch' elements, the way a long-running
+// kernel takes a sequence of fuzz inputs. The host fills batch b+buffers
+// while the device works on batch b, and checks every batch as it comes
+// back instead of waiting for all of them.
+//
+template<typename T, bool use_usm_host_alloc, size_t kIOPipeDepth = 4,
+         size_t kBuffers = 2>
+bool RunStreamingLoopbackSystem(queue& q, size_t batch, size_t batches) {
+  bool passed = true;
+  using Config = LoopbackConfig<T, use_usm_host_alloc, kIOPipeDepth, kBuffers>;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // IO pipes
+#ifndef USE_REAL_IO_PIPES
+  // these are FAKE IO pipes (and their N-buffered producer/consumer)
+  using FakeIOPipeInProducer = StreamProducer<LoopBackReadIOPipeID<Config>,
+                                T, use_usm_host_alloc, kIOPipeDepth, kBuffers>;
+  using FakeIOPipeOutConsumer = StreamConsumer<LoopBackWriteIOPipeID<Config>,
+                                 T, use_usm_host_alloc, kIOPipeDepth, kBuffers>;
+  using ReadIOPipe = typename FakeIOPipeInProducer::Pipe;
+  using WriteIOPipe = typename FakeIOPipeOutConsumer::Pipe;
+
+  FakeIOPipeInProducer::Init(q, batch);
+  FakeIOPipeOutConsumer::Init(q, batch);
+#else
+  // these are REAL IO pipes
+  using ReadIOPipe =
+    ext::intel::kernel_readable_io_pipe<LoopBackReadIOPipeID<Config>,
+                                   T, kIOPipeDepth>;
+  using WriteIOPipe =
+    ext::intel::kernel_writeable_io_pipe<LoopBackWriteIOPipeID<Config>,
+                                    T, kIOPipeDepth>;
+#endif
+  //////////////////////////////////////////////////////////////////////////////
+
+  // one launch of the main processing kernel for the whole stream
+  auto kernel_event =
+      SubmitLoopbackKernel<Config, ReadIOPipe, WriteIOPipe>(q, batch * batches);
+
+  // FAKE IO PIPES ONLY
+#ifndef USE_REAL_IO_PIPES
+  // element i of batch b, so that every batch can be checked on its own
+  auto value = [&](size_t b, size_t i) { return T((b * batch + i) % 100); };
+
+  // fill the next free input buffer and start moving it, along with the
+  // output buffer it comes back in
+  auto launch = [&](size_t b) {
+    T *in = FakeIOPipeInProducer::Acquire();
+    for (size_t i = 0; i < batch; i++) in[i] = value(b, i);
+    FakeIOPipeInProducer::Launch(q);
+    FakeIOPipeOutConsumer::Launch(q);
+  };
+
+  for (size_t b = 0; b < batches && b < kBuffers; b++) launch(b);
+
+  for (size_t b = 0; b < batches; b++) {
+    T *out = FakeIOPipeOutConsumer::Take();
+
+    // validate the batch
+    for (size_t i = 0; i < batch; i++) {
+      if (out[i] != value(b, i)) {
+        std::cerr << "ERROR: output mismatch at entry " << i << " of batch "
+                  << b << ": " << out[i] << " != " << value(b, i)
+                  << " (out != in)\n";
+        passed &= false;
+      }
+    }
+
+    // its buffers are free again, put the next batch in them
+    if (b + kBuffers < batches) launch(b + kBuffers);
+  }
+#endif
+
+  kernel_event.wait();
+
+#ifndef USE_REAL_IO_PIPES
+  FakeIOPipeInProducer::Destroy(q);
+  FakeIOPipeOutConsumer::Destroy(q);
 #endif
 
   return passed;
@@ -0,0 +1,112 @@
+#ifndef __MUTATIONBATCH_HPP__
+#define __MUTATIONBATCH_HPP__
+
+#include <cstdint>
+#include <limits>
+
+#include <CL/sycl.hpp>
+
+#include "../common/Random.hpp"
+#include "type.hpp"
+
+using namespace sycl;
+
+//
+// Device mutations in batches of K variants per kernel launch.
+//
+// Rather than one mutate() pass and one force/update pair per step, a
+// harness keeps K copies ("variants") of the system side by side in a
+// buffer of K*n particles. Each step it draws one MutationDesc per variant
+// and runs the mutation, force and update kernels once over all K*n
+// work-items. Variant v owns particles [v*n, (v+1)*n) and the work-groups
+// over them, so its force loop only runs over its own slice:
+//
+//   MutationDesc *descs = malloc_shared<MutationDesc>(kVariants, q);
+//   RealType *stats = malloc_shared<RealType>(kVariants * kStats, q);
+//   ...
+//   PlanMutations(rng, hfuzz::Metrics::Knob(), n, descs);
+//   ResetStats(stats);
+//   h.parallel_for(nd_range<1>(kVariants * n, kWorkGroup), [=](...) {
+//     size_t i = it.get_global_id(0), v = i / n;
+//     tiles.ForEach(it, p, v * n, n, ...);
+//     GroupMax(it, stats[v * kStats + kStatDxMax], dxmax);
+//   });
+//
+// Launch, JIT and transfer costs are then shared by K trajectories, each of
+// which is what a single-variant harness would run as its own test case.
+// GroupMax() and friends fold one value per work-item into the variant's
+// stats with a work-group reduce and one atomic per group, which needs n to
+// be a multiple of the work-group size (the nd_range does already).
+//
+// -DGSIM_VARIANTS=4 (the default) sets K.
+//
+#ifndef GSIM_VARIANTS
+#define GSIM_VARIANTS 4
+#endif
+
+constexpr int kVariants = GSIM_VARIANTS;
+
+static_assert(kVariants > 0, "need at least one variant");
+
+// One variant's mutation for a step
+struct MutationDesc {
+  int knob;         // mutate() knob, 1..4
+  int start, end;   // the variant's particles [start, end) it applies to
+  float value;      // scaled per particle by its own uniform draw
+  uint64_t seed;    // per-work-item hfuzz::Rng streams
+};
+
+// Per-variant step values, stats[v * kStats + slot]: maxima at even slots,
+// minima at odd ones, then the sums
+enum {
+  kStatDxMax, kStatDxMin, kStatDyMax, kStatDyMin, kStatDzMax, kStatDzMin,
+  kStatDistanceSqrMax, kStatDistanceSqrMin, kStatAccMax, kStatAccMin,
+  kStatEnergy, kStats
+};
+
+constexpr RealType kLowest = std::numeric_limits<RealType>::lowest();
+constexpr RealType kHighest = std::numeric_limits<RealType>::max();
+
+// Draws every variant's mutation for one step. knob is the fuzzer's choice
+// (hfuzz::Metrics::Knob()); anything outside 1..4 lets each variant pick.
+inline void PlanMutations(hfuzz::Rng &rng, int knob, int n,
+                          MutationDesc *descs) {
+  for (int v = 0; v < kVariants; v++) {
+    MutationDesc &d = descs[v];
+    d.knob = knob >= 1 && knob <= 4 ? knob : rng.Below(3) + 1;
+    d.value = rng.Next() >> 1;
+    d.start = rng.Below(n);
+    d.end = rng.Below(n - d.start) + d.start;
+    d.seed = rng.Next64();
+  }
+}
+
+// Identity of every slot of the first variants, before the kernels of a
+// step fold into them
+inline void ResetStats(RealType *stats, int variants = kVariants) {
+  for (int v = 0; v < variants; v++)
+    for (int s = 0; s < kStats; s++)
+      stats[v * kStats + s] = s >= kStatEnergy ? 0 : s % 2 ? kHighest : kLowest;
+}
+
+using StatRef = atomic_ref<RealType, memory_order::relaxed,
+                           memory_scope::device,
+                           access::address_space::global_space>;
+
+// DEVICE CODE, every work-item of the group has to call these
+inline void GroupMax(nd_item<1> it, RealType &dst, RealType v) {
+  v = reduce_over_group(it.get_group(), v, sycl::maximum<RealType>());
+  if (it.get_local_id(0) == 0) StatRef(dst).fetch_max(v);
+}
+
+inline void GroupMin(nd_item<1> it, RealType &dst, RealType v) {
+  v = reduce_over_group(it.get_group(), v, sycl::minimum<RealType>());
+  if (it.get_local_id(0) == 0) StatRef(dst).fetch_min(v);
+}
+
+inline void GroupSum(nd_item<1> it, RealType &dst, RealType v) {
+  v = reduce_over_group(it.get_group(), v, sycl::plus<RealType>());
+  if (it.get_local_id(0) == 0) StatRef(dst).fetch_add(v);
+}
+
+#endif /* __MUTATIONBATCH_HPP__ */
@@ -0,0 +1,317 @@
+#ifndef __PARTICLELAYOUT_HPP__
+#define __PARTICLELAYOUT_HPP__
+
+#include <type_traits>
+#include <vector>
+
+#include <CL/sycl.hpp>
+
+#include "Particle.hpp"
+
+using namespace sycl;
+
+//
+// Device-side layout of the particles, picked at build time.
+//
+// By default the kernels work on the host's array of structs: one buffer of
+// Particle, 40 bytes each. With -DGSIM_SOA=1 the state is split into three
+// buffers of float4 (pos+mass, vel, acc), so the O(n^2) force loop streams
+// only the 16 bytes of pos+mass of every p[j] instead of whole particles,
+// as aligned float4 loads in neighbouring work-items.
+//
+// With -DGSIM_USM=1 (either layout) the state is a malloc_device allocation
+// instead of a buffer. It stays on the device between steps and test cases:
+// nothing is copied back unless the host asks for it with HostAccess(),
+// which is then an explicit O(n) snapshot. USM has no implicit dependencies
+// between kernels, so the harness creates its queue with
+// ParticleBuffer::QueueProperties() (in order under GSIM_USM; profiling
+// always, for the kernel times the harness reports).
+//
+// Kernels are written once for all of them: p[i].pos[k], p[i].mass,
+// p[i].acc[k] work on either layout, and so does the host view.
+//
+//   queue q(d_selector, dpc_common::exception_handler,
+//           ParticleBuffer::QueueProperties());
+//   ParticleBuffer pbuf(q, n);
+//   pbuf.Upload(q, particles_);
+//   q.submit([&](handler& h) {
+//     auto p = pbuf.get_access(h);
+//     h.parallel_for(ndrange, [=](nd_item<1> it) {
+//       auto i = it.get_global_id();
+//       p[i].acc[0] += ...;
+//     });
+//   });
+//   {
+//     auto ph = pbuf.HostAccess();  // read only, release before next submit
+//     ... ph[i].acc[0] ...
+//   }
+//
+// Code that takes a single particle should take a ParticleRef, which is
+// Particle& or the SoA proxy. Input parsing and the host-side
+// std::vector<Particle> stay the same in all layouts. Only the AoS buffer
+// writes results back into that vector; the others are read through
+// HostAccess().
+//
+#ifndef GSIM_SOA
+#define GSIM_SOA 0
+#endif
+
+#ifndef GSIM_USM
+#define GSIM_USM 0
+#endif
+
+#if !GSIM_SOA
+
+using ParticleRef = Particle &;
+
+#else
+
+static_assert(std::is_same<RealType, float>::value,
+              "GSIM_SOA packs RealType into float4");
+
+// One particle seen through the three arrays; V is float4 on the device and
+// const float4 in the host view
+template <typename V>
+struct ParticleView {
+  struct Component {
+    V &v;
+    auto &operator[](int k) const { return v[k]; }
+  };
+
+  Component pos, vel, acc;
+  std::conditional_t<std::is_const<V>::value, const RealType, RealType> &mass;
+};
+
+using ParticleRef = ParticleView<float4>;
+
+// The three float4 of one host particle
+inline void PackParticle(const Particle &p, float4 &pm, float4 &vel,
+                         float4 &acc) {
+  pm = float4(p.pos[0], p.pos[1], p.pos[2], p.mass);
+  vel = float4(p.vel[0], p.vel[1], p.vel[2], 0.f);
+  acc = float4(p.acc[0], p.acc[1], p.acc[2], 0.f);
+}
+
+#endif /* GSIM_SOA */
+
+#if !GSIM_SOA && !GSIM_USM
+
+class ParticleBuffer {
+public:
+  ParticleBuffer(queue &, size_t n) : buf_(range<1>(n)) {}
+
+  // Device copy backed by the host's array (use_host_ptr)
+  ParticleBuffer(queue &, std::vector<Particle> &host)
+      : buf_(host.data(), range<1>(host.size()),
+             {property::buffer::use_host_ptr()}) {}
+
+  // Buffers order the kernels themselves
+  static property_list QueueProperties() {
+    return {property::queue::enable_profiling()};
+  }
+
+  // copies > 1 fills the buffer with that many back-to-back copies of host
+  void Upload(queue &q, const std::vector<Particle> &host, int copies = 1) {
+    range<1> r(host.size());
+    for (int c = 0; c < copies; c++)
+      q.submit([&](handler &h) {
+        accessor p(buf_, h, r, id<1>(c * host.size()), write_only, no_init);
+        h.copy(host.data(), p);
+      });
+  }
+
+  auto get_access(handler &h) { return buf_.get_access(h); }
+  auto HostAccess() { return host_accessor(buf_, read_only); }
+
+private:
+  buffer<Particle, 1> buf_;
+};
+
+#elif GSIM_SOA && !GSIM_USM
+
+class ParticleBuffer {
+public:
+  struct DeviceAccess {
+    accessor<float4, 1, access::mode::read_write> pm, vel, acc;
+
+    ParticleRef operator[](size_t i) const {
+      return {{pm[i]}, {vel[i]}, {acc[i]}, pm[i][3]};
+    }
+  };
+
+  struct HostView {
+    host_accessor<float4, 1, access::mode::read> pm, vel, acc;
+
+    ParticleView<const float4> operator[](size_t i) const {
+      return {{pm[i]}, {vel[i]}, {acc[i]}, pm[i][3]};
+    }
+  };
+
+  ParticleBuffer(queue &, size_t n) : pm_(range<1>(n)), vel_(range<1>(n)),
+                                      acc_(range<1>(n)) {}
+
+  // Device copy of the host's array. Unlike the AoS layout it is not kept
+  // in sync with the host, read results through HostAccess()
+  ParticleBuffer(queue &q, const std::vector<Particle> &host)
+      : ParticleBuffer(q, host.size()) {
+    Pack(host, 1);
+  }
+
+  static property_list QueueProperties() {
+    return {property::queue::enable_profiling()};
+  }
+
+  // The packing is done through host accessors: the buffers are idle
+  // between test cases, and the next kernel moves them to the device
+  void Upload(queue &, const std::vector<Particle> &host, int copies = 1) {
+    Pack(host, copies);
+  }
+
+  DeviceAccess get_access(handler &h) {
+    return {pm_.get_access(h), vel_.get_access(h), acc_.get_access(h)};
+  }
+
+  HostView HostAccess() {
+    return {host_accessor(pm_, read_only), host_accessor(vel_, read_only),
+            host_accessor(acc_, read_only)};
+  }
+
+private:
+  void Pack(const std::vector<Particle> &host, int copies) {
+    host_accessor pm(pm_, write_only, no_init);
+    host_accessor vel(vel_, write_only, no_init);
+    host_accessor acc(acc_, write_only, no_init);
+
+    for (size_t i = 0; i < copies * host.size(); i++)
+      PackParticle(host[i % host.size()], pm[i], vel[i], acc[i]);
+  }
+
+  buffer<float4, 1> pm_, vel_, acc_;
+};
+
+#elif !GSIM_SOA
+
+class ParticleBuffer {
+public:
+  ParticleBuffer(queue &q, size_t n)
+      : q_(q), n_(n), p_(malloc_device<Particle>(n, q)) {}
+
+  ParticleBuffer(queue &q, const std::vector<Particle> &host)
+      : ParticleBuffer(q, host.size()) {
+    Upload(q, host);
+  }
+
+  ~ParticleBuffer() { free(p_, q_); }
+
+  ParticleBuffer(const ParticleBuffer &) = delete;
+  ParticleBuffer &operator=(const ParticleBuffer &) = delete;
+
+  static property_list QueueProperties() {
+    return {property::queue::in_order(),
+            property::queue::enable_profiling()};
+  }
+
+  // Waits for the copies, so host may change as soon as this returns
+  void Upload(queue &q, const std::vector<Particle> &host, int copies = 1) {
+    for (int c = 0; c < copies; c++)
+      q.memcpy(p_ + c * host.size(), host.data(),
+               host.size() * sizeof(Particle));
+    q.wait();
+  }
+
+  Particle *get_access(handler &) const { return p_; }
+
+  // Snapshot of the whole state, once the kernels queued so far are done
+  std::vector<Particle> HostAccess() {
+    std::vector<Particle> host(n_);
+    q_.memcpy(host.data(), p_, n_ * sizeof(Particle)).wait();
+    return host;
+  }
+
+private:
+  queue q_;
+  size_t n_;
+  Particle *p_;
+};
+
+#else
+
+class ParticleBuffer {
+public:
+  struct DeviceAccess {
+    float4 *pm, *vel, *acc;
+
+    ParticleRef operator[](size_t i) const {
+      return {{pm[i]}, {vel[i]}, {acc[i]}, pm[i][3]};
+    }
+  };
+
+  struct HostView {
+    std::vector<float4> pm, vel, acc;
+
+    ParticleView<const float4> operator[](size_t i) const {
+      return {{pm[i]}, {vel[i]}, {acc[i]}, pm[i][3]};
+    }
+  };
+
+  ParticleBuffer(queue &q, size_t n)
+      : q_(q), n_(n), pm_(malloc_device<float4>(n, q)),
+        vel_(malloc_device<float4>(n, q)), acc_(malloc_device<float4>(n, q)) {}
+
+  ParticleBuffer(queue &q, const std::vector<Particle> &host)
+      : ParticleBuffer(q, host.size()) {
+    Upload(q, host);
+  }
+
+  ~ParticleBuffer() {
+    free(pm_, q_);
+    free(vel_, q_);
+    free(acc_, q_);
+  }
+
+  ParticleBuffer(const ParticleBuffer &) = delete;
+  ParticleBuffer &operator=(const ParticleBuffer &) = delete;
+
+  static property_list QueueProperties() {
+    return {property::queue::in_order(),
+            property::queue::enable_profiling()};
+  }
+
+  // Packed on the host once, then copied to every copy's slice
+  void Upload(queue &q, const std::vector<Particle> &host, int copies = 1) {
+    size_t n = host.size();
+    HostView v{std::vector<float4>(n), std::vector<float4>(n),
+               std::vector<float4>(n)};
+    for (size_t i = 0; i < n; i++)
+      PackParticle(host[i], v.pm[i], v.vel[i], v.acc[i]);
+
+    for (int c = 0; c < copies; c++) {
+      q.memcpy(pm_ + c * n, v.pm.data(), n * sizeof(float4));
+      q.memcpy(vel_ + c * n, v.vel.data(), n * sizeof(float4));
+      q.memcpy(acc_ + c * n, v.acc.data(), n * sizeof(float4));
+    }
+    q.wait();
+  }
+
+  DeviceAccess get_access(handler &) const { return {pm_, vel_, acc_}; }
+
+  // Snapshot of the whole state, once the kernels queued so far are done
+  HostView HostAccess() {
+    HostView v{std::vector<float4>(n_), std::vector<float4>(n_),
+               std::vector<float4>(n_)};
+    q_.memcpy(v.pm.data(), pm_, n_ * sizeof(float4));
+    q_.memcpy(v.vel.data(), vel_, n_ * sizeof(float4));
+    q_.memcpy(v.acc.data(), acc_, n_ * sizeof(float4));
+    q_.wait();
+    return v;
+  }
+
+private:
+  queue q_;
+  size_t n_;
+  float4 *pm_, *vel_, *acc_;
+};
+
+#endif
+
+#endif /* __PARTICLELAYOUT_HPP__ */
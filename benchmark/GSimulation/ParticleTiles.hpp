@@ -0,0 +1,100 @@
+#ifndef __PARTICLETILES_HPP__
+#define __PARTICLETILES_HPP__
+
+#include <type_traits>
+
+#include <CL/sycl.hpp>
+
+#include "Particle.hpp"
+
+using namespace sycl;
+
+//
+// Work-group tiling for the all-pairs loop of the force kernels.
+//
+// Without it every work-item streams the pos/mass of all n particles from
+// global memory on its own. ParticleTiles has the work-group load them into
+// local memory cooperatively, Tile particles at a time, and runs the loop
+// body over the tile from there, so each particle is read from global
+// memory once per work-group instead of once per work-item:
+//
+//   q.submit([&](handler& h) {
+//     auto p = pbuf.get_access(h);
+//     ParticleTiles<kWorkGroup, kTile> tiles(h);
+//     h.parallel_for(nd_range<1>(n, kWorkGroup), [=](nd_item<1> it) {
+//       auto i = it.get_global_id();
+//       tiles.ForEach(it, p, n, [&](int j, const float4 &pj) {
+//         dx = pj[0] - p[i].pos[0];  // pj = (pos[0], pos[1], pos[2], mass)
+//         ...
+//       });
+//     });
+//   });
+//
+// The body still sees j = 0 .. n-1 in order, with the values p[j] had when
+// the kernel started, so anything it tracks (probes, coverage, the
+// accumulation order of acc) comes out as with the plain loop, provided the
+// kernel does not write pos or mass. ForEach contains work-group barriers:
+// every work-item of the group has to call it.
+//
+// Both sizes are picked at build time, -DGSIM_WORK_GROUP=128 and
+// -DGSIM_TILE=128 by default; -DGSIM_TILE=0 keeps the untiled loop.
+//
+#ifndef GSIM_WORK_GROUP
+#define GSIM_WORK_GROUP 128
+#endif
+
+#ifndef GSIM_TILE
+#define GSIM_TILE GSIM_WORK_GROUP
+#endif
+
+constexpr int kWorkGroup = GSIM_WORK_GROUP;
+constexpr int kTile = GSIM_TILE;
+
+static_assert(std::is_same<RealType, float>::value,
+              "tiles hold pos/mass as float4");
+
+template <int WorkGroup, int Tile>
+class ParticleTiles {
+  static_assert(WorkGroup > 0 && Tile >= 0, "bad work-group or tile size");
+
+public:
+  explicit ParticleTiles(handler &h) : tile_(range<1>(Tile ? Tile : 1), h) {}
+
+  // Calls body(j, pj) for j = 0 .. n-1, pj = (pos[0], pos[1], pos[2], mass)
+  template <typename Access, typename Body>
+  void ForEach(nd_item<1> it, const Access &p, int n, Body &&body) const {
+    ForEach(it, p, 0, n, body);
+  }
+
+  // Same over the n particles starting at p[first], e.g. one slice of a
+  // buffer that holds several copies of the system; j is relative to first
+  template <typename Access, typename Body>
+  void ForEach(nd_item<1> it, const Access &p, size_t first, int n,
+               Body &&body) const {
+    if constexpr (Tile == 0) {
+      for (int j = 0; j < n; j++) body(j, Load(p, first + j));
+    } else {
+      for (int base = 0; base < n; base += Tile) {
+        for (int l = it.get_local_id(0); l < Tile && base + l < n;
+             l += WorkGroup)
+          tile_[l] = Load(p, first + base + l);
+        group_barrier(it.get_group());
+
+        int cnt = n - base < Tile ? n - base : Tile;
+        for (int l = 0; l < cnt; l++) body(base + l, tile_[l]);
+        // the tile is overwritten next round only once everyone is done
+        group_barrier(it.get_group());
+      }
+    }
+  }
+
+private:
+  template <typename Access>
+  static float4 Load(const Access &p, size_t j) {
+    return float4(p[j].pos[0], p[j].pos[1], p[j].pos[2], p[j].mass);
+  }
+
+  local_accessor<float4, 1> tile_;
+};
+
+#endif /* __PARTICLETILES_HPP__ */
@@ -0,0 +1,125 @@
+//==============================================================
+// Throughput of the harness plumbing: how fast the (fake or real) IO pipes
+// of LoopbackTest.hpp move a stream of batches through a loopback kernel.
+//
+// Sweeps the element type, the IO pipe depth, USM host vs device
+// allocations and the batch size, at a fixed total stream size, and prints
+// one CSV line per configuration:
+//
+//   pipes,type,depth,host_alloc,batch,batches,seconds,gbps,passed
+//
+// gbps counts the bytes streamed in, once. Build with -DUSE_REAL_IO_PIPES
+// for a BSP with IO pipes; the fake pipes' host_alloc=1 rows are skipped on
+// devices without USM host allocations.
+//
+//   ./pipe_bench [total_MiB]     (default 64)
+// =============================================================
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <CL/sycl.hpp>
+#if FPGA || FPGA_EMULATOR
+  #include <sycl/ext/intel/fpga_extensions.hpp>
+#endif
+
+// dpc_common.hpp can be found in the dev-utilities include folder.
+// e.g., $ONEAPI_ROOT/dev-utilities/latest/include/dpc_common.hpp
+#include "dpc_common.hpp"
+#include "LoopbackTest.hpp"
+
+using namespace sycl;
+
+template <typename T> struct TypeName;
+template <> struct TypeName<char> { static constexpr const char *value = "char"; };
+template <> struct TypeName<int> { static constexpr const char *value = "int"; };
+template <> struct TypeName<double> { static constexpr const char *value = "double"; };
+
+#ifndef USE_REAL_IO_PIPES
+static constexpr const char *kPipes = "fake";
+#else
+static constexpr const char *kPipes = "real";
+#endif
+
+static constexpr size_t kBatchSizes[] = {1 << 10, 1 << 14, 1 << 18};
+
+template <typename T, bool host_alloc, size_t depth>
+static bool RunOne(queue &q, size_t total_bytes) {
+  bool passed = true;
+
+  for (size_t batch : kBatchSizes) {
+    size_t batches = total_bytes / (batch * sizeof(T));
+    if (batches == 0) batches = 1;
+
+    // warm up: the first launch of a kernel pays for loading it
+    RunStreamingLoopbackSystem<T, host_alloc, depth>(q, batch, 2);
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = RunStreamingLoopbackSystem<T, host_alloc, depth>(q, batch,
+                                                               batches);
+    std::chrono::duration<double> diff =
+        std::chrono::steady_clock::now() - start;
+
+    double bytes = double(batch) * batches * sizeof(T);
+    std::cout << kPipes << "," << TypeName<T>::value << "," << depth << ","
+              << host_alloc << "," << batch << "," << batches << ","
+              << diff.count() << "," << bytes / diff.count() * 1e-9 << ","
+              << ok << "\n";
+    passed &= ok;
+  }
+
+  return passed;
+}
+
+template <typename T, size_t... depths>
+static bool RunType(queue &q, size_t total_bytes, bool has_host_alloc) {
+  bool passed = true;
+  ((passed &= RunOne<T, false, depths>(q, total_bytes)), ...);
+#ifndef USE_REAL_IO_PIPES
+  // real IO pipes do not go through host memory, the flag does not apply
+  if (has_host_alloc)
+    ((passed &= RunOne<T, true, depths>(q, total_bytes)), ...);
+#endif
+  return passed;
+}
+
+int main(int argc, char **argv) {
+  size_t total_mib = argc > 1 ? std::atoi(argv[1]) : 64;
+  size_t total_bytes = total_mib << 20;
+
+#if FPGA_EMULATOR
+  // DPC++ extension: FPGA emulator selector on systems without FPGA card.
+  ext::intel::fpga_emulator_selector d_selector;
+#elif FPGA
+  // DPC++ extension: FPGA selector on systems with FPGA card.
+  ext::intel::fpga_selector d_selector;
+#else
+  // The default device selector will select the most performant device.
+  default_selector d_selector;
+#endif
+
+  bool passed = true;
+  try {
+    queue q(d_selector, dpc_common::exception_handler);
+    device d = q.get_device();
+    bool has_host_alloc = d.get_info<info::device::usm_host_allocations>();
+
+    std::cerr << "Device: " << d.get_info<info::device::name>() << "\n";
+    std::cout << "pipes,type,depth,host_alloc,batch,batches,seconds,gbps,"
+                 "passed\n";
+
+    passed &= RunType<char, 4, 64>(q, total_bytes, has_host_alloc);
+    passed &= RunType<int, 4, 64>(q, total_bytes, has_host_alloc);
+    passed &= RunType<double, 4, 64>(q, total_bytes, has_host_alloc);
+  } catch (sycl::exception const &e) {
+    std::cerr << "Caught a SYCL host exception:\n" << e.what() << "\n";
+    std::terminate();
+  }
+
+  if (!passed) {
+    std::cerr << "FAILED\n";
+    return 1;
+  }
+  return 0;
+}
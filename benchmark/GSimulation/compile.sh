@@ -19,11 +19,26 @@
 ###########################################################################################################
 
 # Initial Setup
+# Hardware builds go through the build cache (build_cache.sh at the top of
+# the HFuzz checkout): a job whose sources and flags were built before
+# reuses that bitstream instead of compiling it again
+BUILD=${HFUZZ_ROOT:-~/HFuzz}/build_cache.sh
 cd ~/A10_oneapi/GSimulation
 # Job will exit if directory already exists; no overwrite. No error message.
 # [ ! -d ~/A10_ONEAPI/vector-add ] && mkdir -p ~/A10_ONEAPI/vector-add || exit 0
-dpcpp -fintelfpga -Xshardware src/main.cpp src/GSimulation_prob_kernel_variable.cpp -o nbody_hfuzz_probe.fpga
-#dpcpp -fintelfpga -Xshardware src/main.cpp src/GSimulation_noprob_kernel_variable.cpp -o nbody_hfuzz_noprobe.fpga
+# One source for every build, the -DHFUZZ_* switches pick what is compiled in (benchmark/common/HarnessPolicy.hpp)
+$BUILD dpcpp -fintelfpga -Xshardware src/main.cpp src/GSimulation.cpp -o nbody_hfuzz_probe.fpga
+# Uninstrumented baseline: no probes, no device mutation
+#$BUILD dpcpp -fintelfpga -Xshardware -DHFUZZ_PROBES=0 -DHFUZZ_MUTATION=0 src/main.cpp src/GSimulation.cpp -o nbody_hfuzz_noprobe.fpga
+# acc reported per work-item through the side channel instead of reduced on the device
+#$BUILD dpcpp -fintelfpga -Xshardware -DHFUZZ_SIDE_CHANNEL=1 src/main.cpp src/GSimulation.cpp -o nbody_hfuzz_probe_sc.fpga
+# Same design with the particles in float4 pos+mass/vel/acc buffers (ParticleLayout.hpp)
+#$BUILD dpcpp -fintelfpga -Xshardware -DGSIM_SOA=1 src/main.cpp src/GSimulation.cpp -o nbody_hfuzz_probe_soa.fpga
+# Particle state kept in device USM between steps (GSIM_USM in ParticleLayout.hpp)
+#$BUILD dpcpp -fintelfpga -Xshardware -DGSIM_USM=1 src/main.cpp src/GSimulation.cpp -o nbody_hfuzz_probe_usm.fpga
+# Throughput of the fake IO pipes (PipeBench.cpp), and of the real ones on a BSP that has them
+#$BUILD dpcpp -fintelfpga -Xshardware -DFPGA=1 src/PipeBench.cpp -o pipe_bench.fpga
+#$BUILD dpcpp -fintelfpga -Xshardware -DFPGA=1 -DUSE_REAL_IO_PIPES src/PipeBench.cpp -o pipe_bench_io.fpga
 # Copy Over sample design
 # cd ~/A10_ONEAPI/vector-add
 # wget -N https://raw.githubusercontent.com/intel/FPGA-Devcloud/master/main/QuickStartGuides/OneAPI_Program_PAC_Quickstart/Arria%2010/download-file-list.txt
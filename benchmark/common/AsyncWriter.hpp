@@ -0,0 +1,116 @@
+#ifndef __ASYNCWRITER_HPP__
+#define __ASYNCWRITER_HPP__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+
+//
+// Per-step output of a harness, formatted off the main thread.
+//
+// The step loop pushes plain records into a single-producer/single-consumer
+// ring and goes back to submitting kernels. A writer thread pops them and
+// formats them into one text buffer, which Finish() writes out in one go at
+// the end of the test case:
+//
+//   hfuzz::AsyncWriter<StepRow> rows([](std::string &out, const StepRow &r) {
+//     out += ...;
+//   });
+//   for (...) rows.Push({s, energy, elapsed});
+//   rows.Finish(std::cout);
+//
+// Push() only blocks when the writer is Capacity records behind. The
+// thread lives as long as the writer; in a fork server keep the writer
+// inside the test case, so no thread is alive when the server forks.
+//
+namespace hfuzz {
+
+// Lock-free ring for one producer and one consumer thread
+template <typename T, size_t Capacity>
+class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+public:
+  bool Push(const T &v) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity) return false;
+    ring_[head & (Capacity - 1)] = v;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool Pop(T &v) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    v = ring_[tail & (Capacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::array<T, Capacity> ring_;
+  // on separate lines, producer and consumer each own one
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+template <typename Record, size_t Capacity = 1024>
+class AsyncWriter {
+public:
+  using Format = std::function<void(std::string &, const Record &)>;
+
+  explicit AsyncWriter(Format format)
+      : format_(std::move(format)), thread_([this] { Run(); }) {}
+
+  // disable copy constructor and operator=
+  AsyncWriter(const AsyncWriter &)=delete;
+  AsyncWriter& operator=(AsyncWriter const &)=delete;
+
+  ~AsyncWriter() { Stop(); }
+
+  void Push(const Record &r) {
+    while (!queue_.Push(r)) std::this_thread::yield();
+  }
+
+  // Formats whatever is still queued, stops the thread and writes the text
+  // of all records to out
+  void Finish(std::ostream &out) {
+    Stop();
+    out << text_;
+    out.flush();
+    text_.clear();
+  }
+
+private:
+  void Run() {
+    Record r;
+    for (;;) {
+      bool done = done_.load(std::memory_order_acquire);
+      while (queue_.Pop(r)) format_(text_, r);
+      if (done) return;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  void Stop() {
+    if (!thread_.joinable()) return;
+    done_.store(true, std::memory_order_release);
+    thread_.join();
+  }
+
+  Format format_;
+  SpscQueue<Record, Capacity> queue_;
+  std::string text_;
+  std::atomic<bool> done_{false};
+  std::thread thread_;  // last: starts once everything above is set up
+};
+
+}  // namespace hfuzz
+
+#endif /* __ASYNCWRITER_HPP__ */
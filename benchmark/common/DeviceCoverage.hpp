@@ -0,0 +1,170 @@
+#ifndef __DEVICECOVERAGE_HPP__
+#define __DEVICECOVERAGE_HPP__
+
+#include <sys/shm.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <CL/sycl.hpp>
+
+using namespace sycl;
+
+//
+// Branch coverage for SYCL kernels, merged into the fuzzer's coverage map.
+//
+// Host-side instrumentation never sees what happens inside a parallel_for.
+// A kernel that wants the fuzzer to see its branches attaches a coverage
+// map to its command group and wraps the conditions it cares about in
+// HFUZZ_COV:
+//
+//   q.submit([&](handler &h) {
+//     auto cov = hfuzz::DeviceCoverage::Attach(h);
+//     h.parallel_for(ndrange, [=](nd_item<1> it) {
+//       cov.Begin(it);
+//       ...
+//       if (HFUZZ_COV(cov, dx > dxmax)) dxmax = dx;
+//       ...
+//       cov.End(it);
+//     });
+//   }).wait();
+//   hfuzz::DeviceCoverage::Merge();
+//
+// Each probe site (its __LINE__) gets two slots, taken and not taken.
+// Probes only touch a bitmap in local memory, and only the first hit of a
+// slot in a work-group costs an atomic; End() folds the work-group bitmap
+// into a USM bitmap with at most one global atomic per word. Merge() then
+// adds every slot that was hit to the fuzzer's map, so the hit-count
+// buckets see how many kernel launches took a branch.
+//
+// Device slots live in the last kDevCovSlots bytes of the map. They can
+// collide with host-side edges like any two AFL edges can.
+//
+// Rules for the call site:
+//  - the kernel must be launched over an nd_range, and every work-item has
+//    to reach Begin() and End() (they contain work-group barriers);
+//  - Init() once after the queue is created, Merge() after every kernel
+//    that carries probes has finished.
+//
+// When the binary is not started by the fuzzer there is no map to merge
+// into, and Merge() just clears the device bitmap.
+//
+namespace hfuzz {
+
+constexpr size_t kCovMapSize = 1 << 16;  // must match MAP_SIZE in config.h
+constexpr size_t kDevCovSlots = 4096;
+constexpr size_t kDevCovWords = kDevCovSlots / 32;
+constexpr char kShmEnvVar[] = "__AFL_SHM_ID";  // SHM_ENV_VAR in config.h
+
+class DeviceCoverage {
+public:
+  // Per-kernel handle, captured by value by the kernel lambda
+  struct Probe {
+    local_accessor<uint32_t, 1> local;
+    uint32_t *global;
+
+    void Begin(nd_item<1> it) const {
+      for (size_t w = it.get_local_id(0); w < kDevCovWords;
+           w += it.get_local_range(0))
+        local[w] = 0;
+      group_barrier(it.get_group());
+    }
+
+    void End(nd_item<1> it) const {
+      group_barrier(it.get_group());
+      for (size_t w = it.get_local_id(0); w < kDevCovWords;
+           w += it.get_local_range(0)) {
+        uint32_t bits = local[w];
+        if (!bits) continue;
+        atomic_ref<uint32_t, memory_order::relaxed, memory_scope::device,
+                   access::address_space::global_space>(global[w])
+            .fetch_or(bits);
+      }
+    }
+
+    bool Hit(uint32_t slot, bool cond) const {
+      slot = (slot * 2 + cond) % kDevCovSlots;
+      uint32_t bit = 1u << (slot % 32);
+      // plain load first: after the first hit a probe costs no atomic
+      if (!(local[slot / 32] & bit))
+        atomic_ref<uint32_t, memory_order::relaxed, memory_scope::work_group,
+                   access::address_space::local_space>(local[slot / 32])
+            .fetch_or(bit);
+      return cond;
+    }
+  };
+
+  // Stand-in for builds that compile their probes out: no local memory,
+  // no barriers, Hit() is just the condition
+  struct NoProbe {
+    void Begin(nd_item<1>) const {}
+    void End(nd_item<1>) const {}
+    bool Hit(uint32_t, bool cond) const { return cond; }
+  };
+
+  // disable copy constructor and operator=
+  DeviceCoverage()=delete;
+  DeviceCoverage(const DeviceCoverage &)=delete;
+  DeviceCoverage& operator=(DeviceCoverage const &)=delete;
+
+  static void Init(queue &q) {
+    map_ = malloc_shared<uint32_t>(kDevCovWords, q);
+    memset(map_, 0, kDevCovWords * sizeof(uint32_t));
+
+    // the fuzzer's map: attach once, it stays valid across test cases
+    const char *id_str = getenv(kShmEnvVar);
+    if (id_str) {
+      void *area = shmat(atoi(id_str), NULL, 0);
+      if (area != (void *)-1) trace_bits_ = (uint8_t *)area;
+    }
+  }
+
+  static void Destroy(queue &q) {
+    free(map_, q);
+    map_ = nullptr;
+    if (trace_bits_) shmdt(trace_bits_);
+    trace_bits_ = nullptr;
+  }
+
+  static Probe Attach(handler &h) {
+    return Probe{local_accessor<uint32_t, 1>(range<1>(kDevCovWords), h),
+                 map_};
+  }
+
+  // Attach(h), or a NoProbe when Enabled is false (see HarnessPolicy.hpp)
+  template <bool Enabled>
+  static auto AttachIf(handler &h) {
+    if constexpr (Enabled) return Attach(h);
+    else return NoProbe{};
+  }
+
+  // Add the slots hit since the last merge to the fuzzer's map and clear
+  // the device bitmap for the next kernel
+  static void Merge() {
+    uint8_t *dst = trace_bits_ ? trace_bits_ + kCovMapSize - kDevCovSlots
+                               : nullptr;
+
+    for (size_t w = 0; w < kDevCovWords; w++) {
+      uint32_t bits = map_[w];
+      if (!bits) continue;
+      map_[w] = 0;
+      if (!dst) continue;
+      for (size_t b = 0; b < 32; b++) {
+        uint8_t &cnt = dst[w * 32 + b];
+        if ((bits >> b & 1) && cnt != 0xff) cnt++;
+      }
+    }
+  }
+
+protected:
+  static inline uint32_t *map_{nullptr};
+  static inline uint8_t *trace_bits_{nullptr};
+};
+
+}  // namespace hfuzz
+
+// Records whether cond was taken at this probe site and yields cond
+#define HFUZZ_COV(cov, cond) ((cov).Hit(__LINE__, static_cast<bool>(cond)))
+
+#endif /* __DEVICECOVERAGE_HPP__ */
@@ -0,0 +1,140 @@
+#ifndef __FORKSERVER_HPP__
+#define __FORKSERVER_HPP__
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+
+//
+// Target side of the hetero-fuzz fork server (run with 'fuzz -F').
+//
+// Without a fork server every test case pays for process startup, dynamic
+// linking, SYCL runtime initialization and device discovery. Calling
+// hfuzz::StartForkServer() once that work is done parks the process: the
+// fuzzer then asks for a new test case over a control pipe, we fork, and
+// only the child returns from StartForkServer() to run the input. The
+// protocol is the one AFL uses, so the file descriptors below must agree
+// with FORKSRV_FD in the fuzzer's config.h.
+//
+// Rules for the call site:
+//  - call it after the queue is constructed, but before the input file is
+//    opened (the fuzzer rewrites the input between forks);
+//  - there must be no work in flight on the device when it is called.
+//
+// When the binary is not started by the fuzzer (or the fuzzer runs without
+// -F) the handshake write fails and the call is a no-op, so harnesses can
+// call it unconditionally.
+//
+// Persistent mode goes one step further: a harness that wraps its per-input
+// work in
+//
+//   while (hfuzz::PersistentLoop(1000)) { ... }
+//
+// keeps its queue, device allocations and JIT-compiled kernels alive and
+// runs up to 1000 inputs in the same child. After each input the child
+// stops itself; the fuzzer then rewrites the input, clears the coverage map
+// and the fork server resumes the child instead of forking a new one.
+// PersistentLoop() starts the fork server itself, so a persistent harness
+// must not call StartForkServer() before it.
+//
+namespace hfuzz {
+
+constexpr int kForkSrvFd = 198;
+
+namespace detail {
+inline bool fsrv_started = false;  // StartForkServer() was called
+inline bool fsrv_running = false;  // ... and the fuzzer answered
+inline bool fsrv_persistent = false;
+}  // namespace detail
+
+inline void StartForkServer() {
+  if (detail::fsrv_started) return;
+  detail::fsrv_started = true;
+
+  // phone home: if nobody is listening we are running stand-alone
+  uint32_t tmp = 0;
+  if (write(kForkSrvFd + 1, &tmp, 4) != 4) return;
+  detail::fsrv_running = true;
+
+  pid_t child_pid = -1;
+  bool child_stopped = false;
+
+  while (true) {
+    uint32_t was_killed;
+    int status;
+
+    // wait for the fuzzer to ask for a new test case
+    if (read(kForkSrvFd, &was_killed, 4) != 4) _exit(1);
+
+    // the fuzzer killed a stopped persistent child (e.g. on a timeout),
+    // reap it before forking a replacement
+    if (child_stopped && was_killed) {
+      child_stopped = false;
+      if (waitpid(child_pid, &status, 0) < 0) _exit(1);
+    }
+
+    if (!child_stopped) {
+      child_pid = fork();
+      if (child_pid < 0) _exit(1);
+
+      if (!child_pid) {
+        // the child runs the test case and never talks to the fuzzer. It
+        // gets a process group of its own: on a timeout the fuzzer kills
+        // the group, which must not take the fork server along
+        setpgid(0, 0);
+        close(kForkSrvFd);
+        close(kForkSrvFd + 1);
+        return;
+      }
+    } else {
+      // persistent child is parked in raise(SIGSTOP), let it take the next
+      // input
+      kill(child_pid, SIGCONT);
+      child_stopped = false;
+    }
+
+    if (write(kForkSrvFd + 1, &child_pid, 4) != 4) _exit(1);
+    if (waitpid(child_pid, &status,
+                detail::fsrv_persistent ? WUNTRACED : 0) < 0)
+      _exit(1);
+    if (WIFSTOPPED(status)) child_stopped = true;
+    if (write(kForkSrvFd + 1, &status, 4) != 4) _exit(1);
+  }
+}
+
+// Returns true as long as the harness should run another input. The first
+// call starts the fork server; every later call hands control back to the
+// fuzzer until the next input is ready. After max_cnt inputs the child
+// exits normally (so leaks and device state cannot pile up forever) and the
+// fork server forks a fresh one.
+inline bool PersistentLoop(unsigned max_cnt) {
+  static bool first_pass = true;
+  static unsigned cycle_cnt;
+
+  if (first_pass) {
+    first_pass = false;
+    cycle_cnt = max_cnt;
+    if (!detail::fsrv_started) {
+      detail::fsrv_persistent = true;
+      StartForkServer();
+    }
+    return true;
+  }
+
+  // stand-alone runs and non-persistent fork servers do one input only
+  if (!detail::fsrv_running || !detail::fsrv_persistent) return false;
+
+  if (--cycle_cnt) {
+    raise(SIGSTOP);
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace hfuzz
+
+#endif /* __FORKSERVER_HPP__ */
@@ -0,0 +1,70 @@
+#ifndef __HARNESSPOLICY_HPP__
+#define __HARNESSPOLICY_HPP__
+
+//
+// What a benchmark harness compiles in, picked at build time.
+//
+// A harness is written once. Its probes, device mutation and side-channel
+// reporting sit behind if constexpr on a HarnessPolicy instead of living in
+// separate copies of the source:
+//
+//   using Harness = hfuzz::BuildPolicy;
+//   ...
+//   if constexpr (Harness::kProbes >= 1) {
+//     if (HFUZZ_COV(cov, d > dmax)) dmax = d;
+//   }
+//
+// A disabled feature is a discarded branch, so it costs nothing at run
+// time, not even a test of a flag. The build with -DHFUZZ_PROBES=0 is the
+// uninstrumented baseline, and comparing it with the default build gives
+// the exact overhead of the probes.
+//
+//   -DHFUZZ_PROBES=2       0: none, 1: the harness's main probes only,
+//                          2: all of them (default)
+//   -DHFUZZ_MUTATION=1     device-side mutation (default on)
+//   -DHFUZZ_SIDE_CHANNEL=0 report per-work-item values through a side
+//                          channel instead of reducing them on the device
+//   -DHFUZZ_ABORT_ON_MISMATCH=0
+//                          abort on a wrong result, so that the fuzzer
+//                          files the test case as a crash instead of
+//                          only counting it in a probe
+//
+// Each harness documents what the levels mean for it, and ignores the
+// switches it has no use for.
+//
+#ifndef HFUZZ_PROBES
+#define HFUZZ_PROBES 2
+#endif
+
+#ifndef HFUZZ_MUTATION
+#define HFUZZ_MUTATION 1
+#endif
+
+#ifndef HFUZZ_SIDE_CHANNEL
+#define HFUZZ_SIDE_CHANNEL 0
+#endif
+
+#ifndef HFUZZ_ABORT_ON_MISMATCH
+#define HFUZZ_ABORT_ON_MISMATCH 0
+#endif
+
+namespace hfuzz {
+
+template <int Probes, bool Mutation, bool SideChannel, bool AbortOnMismatch>
+struct HarnessPolicy {
+  static_assert(Probes >= 0 && Probes <= 2, "probe level is 0, 1 or 2");
+
+  static constexpr int kProbes = Probes;
+  static constexpr bool kMutation = Mutation;
+  // Only means something when there are probes to report
+  static constexpr bool kSideChannel = SideChannel && Probes > 0;
+  static constexpr bool kAbortOnMismatch = AbortOnMismatch;
+};
+
+using BuildPolicy =
+    HarnessPolicy<HFUZZ_PROBES, HFUZZ_MUTATION != 0, HFUZZ_SIDE_CHANNEL != 0,
+                  HFUZZ_ABORT_ON_MISMATCH != 0>;
+
+}  // namespace hfuzz
+
+#endif /* __HARNESSPOLICY_HPP__ */
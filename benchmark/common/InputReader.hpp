@@ -0,0 +1,198 @@
+#ifndef __INPUTREADER_HPP__
+#define __INPUTREADER_HPP__
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// Reads the numbers of a test case, either as text (whitespace-separated,
+// like a plain std::ifstream) or in HFZB, the binary format the fuzzer
+// writes with -B:
+//
+//   "HFZB"  u32 run_cnt
+//   run_cnt x { u32 type, u32 count, count x int64_t (0) or float (1) }
+//
+// The layout must agree with parse_hfzb() / emit_typed() in
+// hetero-fuzz.cpp. HFZB values keep NaN, Inf and denormals bit-exact.
+//
+// The interface mirrors the std::ifstream calls the harnesses already
+// make, so switching a harness over is a matter of replacing
+//
+//   std::ifstream read(file);
+//
+// with
+//
+//   hfuzz::InputReader read(file);
+//
+// The file is mapped, not streamed: text is parsed in place with
+// std::from_chars (no locale, no per-value stream state) and HFZB is
+// decoded from the mapping as it is read. Read() fills a whole array in
+// one call, which for an HFZB run of floats is a single memcpy from the
+// page cache to the destination, e.g. a malloc_host() buffer:
+//
+//   float *a = malloc_host<float>(n, q);
+//   size_t got = read.Read(a, n);
+//
+namespace hfuzz {
+
+class InputReader {
+public:
+  explicit InputReader(const std::string &file) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    open_ = !fstat(fd, &st);
+    size_ = open_ ? st.st_size : 0;
+    if (size_) {
+      void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) {
+        open_ = false;
+        size_ = 0;
+      } else {
+        base_ = static_cast<const char *>(map);
+        madvise(map, size_, MADV_SEQUENTIAL);
+      }
+    }
+    ::close(fd);
+
+    ptr_ = base_;
+    end_ = base_ + size_;
+    ok_ = open_;
+
+    if (size_ >= 4 && !memcmp(base_, "HFZB", 4)) {
+      binary_ = true;
+      ptr_ += 4;
+      ok_ = Take(runs_left_);
+    }
+  }
+
+  ~InputReader() { close(); }
+
+  // disable copy constructor and operator=
+  InputReader(const InputReader &)=delete;
+  InputReader& operator=(InputReader const &)=delete;
+
+  bool is_open() const { return open_; }
+  explicit operator bool() const { return ok_; }
+
+  void close() {
+    if (base_) munmap(const_cast<char *>(base_), size_);
+    base_ = ptr_ = end_ = nullptr;
+    size_ = 0;
+    ok_ = false;
+  }
+
+  template <typename T>
+  InputReader &operator>>(T &out) {
+    static_assert(std::is_arithmetic<T>::value, "numbers only");
+    ok_ = ok_ && (binary_ ? NextBinary(out) : NextText(out));
+    return *this;
+  }
+
+  // Reads up to n values into out and returns how many it read; short only
+  // at the end of the input or on a malformed value
+  template <typename T>
+  size_t Read(T *out, size_t n) {
+    static_assert(std::is_arithmetic<T>::value, "numbers only");
+    size_t got = 0;
+    while (got < n && ok_) {
+      if (std::is_same<T, float>::value && binary_ && run_type_ == 1 &&
+          run_left_) {
+        size_t k = n - got < run_left_ ? n - got : run_left_;
+        memcpy(out + got, ptr_, k * sizeof(float));
+        ptr_ += k * sizeof(float);
+        run_left_ -= k;
+        got += k;
+        continue;
+      }
+      if (*this >> out[got]) got++;
+    }
+    return got;
+  }
+
+private:
+  template <typename U>
+  bool Take(U &v) {
+    if (size_t(end_ - ptr_) < sizeof(U)) return false;
+    memcpy(&v, ptr_, sizeof(U));
+    ptr_ += sizeof(U);
+    return true;
+  }
+
+  template <typename T>
+  bool NextBinary(T &out) {
+    while (!run_left_) {
+      uint32_t count;
+      if (!runs_left_ || !Take(run_type_) || !Take(count) || run_type_ > 1)
+        return false;
+      runs_left_--;
+      run_left_ = count;
+      if (size_t(end_ - ptr_) / (run_type_ ? 4 : 8) < run_left_) return false;
+    }
+    run_left_--;
+
+    if (run_type_) {
+      float f;
+      Take(f);
+      if (std::is_floating_point<T>::value) {
+        out = static_cast<T>(f);
+      } else if (!std::isfinite(f)) {
+        out = T(0);
+      } else {
+        // Out of range for T is a malformed value, as it is for from_chars
+        double t = std::trunc(f);
+        double hi = std::ldexp(1.0, std::numeric_limits<T>::digits);
+        double lo = std::is_signed<T>::value ? -hi : 0.0;
+        if (t < lo || t >= hi) return false;
+        out = static_cast<T>(t);
+      }
+    } else {
+      int64_t i;
+      Take(i);
+      if constexpr (std::is_integral<T>::value) {
+        if (i < 0 ? !std::is_signed<T>::value ||
+                        i < int64_t(std::numeric_limits<T>::min())
+                  : uint64_t(i) > uint64_t(std::numeric_limits<T>::max()))
+          return false;
+      }
+      out = static_cast<T>(i);
+    }
+    return true;
+  }
+
+  template <typename T>
+  bool NextText(T &out) {
+    while (ptr_ != end_ && isspace(static_cast<unsigned char>(*ptr_))) ptr_++;
+    // from_chars takes no '+', operator>> does
+    if (ptr_ != end_ && *ptr_ == '+') ptr_++;
+
+    auto r = std::from_chars(ptr_, end_, out);
+    if (r.ec != std::errc()) return false;
+    ptr_ = r.ptr;
+    return true;
+  }
+
+  const char *base_ = nullptr, *ptr_ = nullptr, *end_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+  bool ok_ = false;
+  bool binary_ = false;
+  uint32_t runs_left_ = 0, run_type_ = 0;
+  size_t run_left_ = 0;
+};
+
+}  // namespace hfuzz
+
+#endif /* __INPUTREADER_HPP__ */
@@ -0,0 +1,79 @@
+#ifndef __KERNELVARIANTS_HPP__
+#define __KERNELVARIANTS_HPP__
+
+#include <cstddef>
+#include <utility>
+
+//
+// Compile-time kernel configurations a harness can run one of, picked per
+// test case by the fuzzer.
+//
+// A harness lists the configurations it instantiates and writes its kernel
+// launch once, as a generic lambda over the configuration:
+//
+//   using Variants = hfuzz::KernelVariants<hfuzz::KernelConfig<1>,
+//                                          hfuzz::KernelConfig<2>, ...>;
+//   auto run = [&](auto cfg) {
+//     using C = decltype(cfg);
+//     VectorAdd<C::kUnroll>(q, ...);
+//   };
+//   int variant = hfuzz::Metrics::Variant();
+//   if (variant) Variants::Run(variant - 1, run);
+//   else Variants::RunAll(run);
+//
+// Every configuration is its own template instantiation, so it is compiled
+// ahead of time like a hand-written one. The fuzzer treats the variant as
+// another mutation dimension (-V count, see hetero-fuzz.cpp), so a test
+// case costs one configuration instead of all of them, and kept test cases
+// record which configuration they were slow or wrong under.
+//
+namespace hfuzz {
+
+// One point of the configuration space. Harnesses read only the
+// parameters their kernels have
+template <int Unroll = 1, int WorkGroup = 128, int Tile = WorkGroup,
+          int VecWidth = 1>
+struct KernelConfig {
+  static constexpr int kUnroll = Unroll;
+  static constexpr int kWorkGroup = WorkGroup;
+  static constexpr int kTile = Tile;
+  static constexpr int kVecWidth = VecWidth;
+};
+
+template <typename... Configs>
+class KernelVariants {
+  static_assert(sizeof...(Configs) > 0, "need at least one variant");
+
+public:
+  static constexpr int kCount = sizeof...(Configs);
+
+  // disable copy constructor and operator=
+  KernelVariants()=delete;
+  KernelVariants(const KernelVariants &)=delete;
+  KernelVariants& operator=(KernelVariants const &)=delete;
+
+  // Calls f(Config{}) for configuration id, taken modulo kCount so that
+  // any id the fuzzer sends selects something
+  template <typename F>
+  static void Run(int id, F &&f) {
+    id %= kCount;
+    if (id < 0) id += kCount;
+    Run(id, f, std::make_index_sequence<kCount>());
+  }
+
+  // Calls f(Config{}) for every configuration, in order
+  template <typename F>
+  static void RunAll(F &&f) {
+    (f(Configs{}), ...);
+  }
+
+private:
+  template <typename F, std::size_t... I>
+  static void Run(int id, F &f, std::index_sequence<I...>) {
+    ((id == int(I) ? (f(Configs{}), 0) : 0), ...);
+  }
+};
+
+}  // namespace hfuzz
+
+#endif /* __KERNELVARIANTS_HPP__ */
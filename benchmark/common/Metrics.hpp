@@ -0,0 +1,187 @@
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+#include <sys/shm.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//
+// Hardware metrics of a test case, handed to the fuzzer in a fixed-layout
+// record instead of exec_info.txt / exec_fpga_info.txt.
+//
+// The fuzzer creates a second shm segment next to the coverage map and
+// passes its id in __HFUZZ_METRICS_ID; it clears the record before every
+// execution and reads it straight out of memory afterwards. Devcloud jobs
+// run on other nodes and can't see our shm, so without the variable the
+// record is kept in process memory and Flush() writes it to
+// hfuzz_metrics.bin in the working directory (the job directory, for qsub
+// jobs), where the fuzzer picks it up.
+//
+//   hfuzz::Metrics::SetExecTime(total_time);
+//   hfuzz::Metrics::SetKernelTime(device_time);  // profiled, see below
+//   hfuzz::Metrics::Probe(0, dxmax);       // min/max per probe
+//   hfuzz::Metrics::Step(step_time, acc);  // per-step series
+//   hfuzz::Metrics::Flush();               // once per test case
+//
+// Kernel time is the device's own account of the kernels, summed from the
+// command_start / command_end profiling info of their events (the queue
+// needs property::queue::enable_profiling), in seconds. It leaves out the
+// host, the runtime and the transfers, which makes it the less noisy
+// timing, and the fuzzer competes on it instead of the execution time
+// whenever it is there.
+//
+// The record also carries three values the other way: the device mutation
+// knob the fuzzer's scheduler picked for this test case, see Knob(), the
+// kernel variant to run, see Variant(), and the seed for the harness's own
+// random choices, see Seed().
+//
+// The layout must agree with struct hfuzz_metrics in hetero-fuzz.cpp.
+//
+namespace hfuzz {
+
+constexpr char kMetricsEnvVar[] = "__HFUZZ_METRICS_ID";
+constexpr char kMetricsFile[] = "hfuzz_metrics.bin";
+constexpr uint32_t kMetricsMagic = 0x4d5a4648;  // "HFZM"
+constexpr int kMetricsProbes = 16;
+constexpr int kMetricsSteps = 256;
+constexpr char kKnobEnvVar[] = "HFUZZ_KNOB";
+constexpr char kVariantEnvVar[] = "HFUZZ_VARIANT";
+constexpr char kSeedEnvVar[] = "HFUZZ_SEED";
+
+enum : uint32_t {
+  kHasExecTime = 1 << 0,
+  kHasDSPs = 1 << 1,
+  kHasFMax = 1 << 2,
+  kHasGFLOPS = 1 << 3,
+  kHasKernelTime = 1 << 4
+};
+
+struct MetricsRecord {
+  uint32_t magic;       // kMetricsMagic once anything was written
+  uint32_t flags;       // kHas* for the scalars below
+  uint32_t probe_mask;  // bit i set: probe_min/max[i] are valid
+  uint32_t n_steps;     // entries used in the series
+  uint32_t knob;        // device knob to use, set by the fuzzer (0: any)
+  uint32_t variant;     // kernel variant to run, set by the fuzzer (0: any)
+  uint64_t seed;        // seed for the harness's RNG, set by the fuzzer
+  double exec_time, dsps, fmax, gflops, kernel_time;
+  double probe_min[kMetricsProbes], probe_max[kMetricsProbes];
+  double step_time[kMetricsSteps], step_value[kMetricsSteps];
+};
+
+class Metrics {
+public:
+  // disable copy constructor and operator=
+  Metrics()=delete;
+  Metrics(const Metrics &)=delete;
+  Metrics& operator=(Metrics const &)=delete;
+
+  static void SetExecTime(double v) { Set(Get().exec_time, v, kHasExecTime); }
+  static void SetDSPs(double v) { Set(Get().dsps, v, kHasDSPs); }
+  static void SetFMax(double v) { Set(Get().fmax, v, kHasFMax); }
+  static void SetGFLOPS(double v) { Set(Get().gflops, v, kHasGFLOPS); }
+  static void SetKernelTime(double v) {
+    Set(Get().kernel_time, v, kHasKernelTime);
+  }
+
+  // Track the extremes of a value the kernel reports (e.g. side channel
+  // reads) under probe id idx
+  static void Probe(int idx, double v) {
+    MetricsRecord &r = Get();
+    if (idx < 0 || idx >= kMetricsProbes) return;
+    r.magic = kMetricsMagic;
+    if (!(r.probe_mask & 1u << idx)) {
+      r.probe_mask |= 1u << idx;
+      r.probe_min[idx] = r.probe_max[idx] = v;
+    } else {
+      if (v < r.probe_min[idx]) r.probe_min[idx] = v;
+      if (v > r.probe_max[idx]) r.probe_max[idx] = v;
+    }
+  }
+
+  // Append one entry of the per-step series; steps past kMetricsSteps are
+  // dropped
+  static void Step(double time, double value) {
+    MetricsRecord &r = Get();
+    r.magic = kMetricsMagic;
+    if (r.n_steps == kMetricsSteps) return;
+    r.step_time[r.n_steps] = time;
+    r.step_value[r.n_steps] = value;
+    r.n_steps++;
+  }
+
+  // End of a test case. With shm there is nothing to do; otherwise write the
+  // record out and start a new one
+  static void Flush() {
+    MetricsRecord &r = Get();
+    if (shared_) return;
+    FILE *f = fopen(kMetricsFile, "wb");
+    if (f) {
+      fwrite(&r, sizeof(r), 1, f);
+      fclose(f);
+    }
+    memset(&r, 0, sizeof(r));
+  }
+
+  // Device mutation knob (1-based) the fuzzer wants this test case to
+  // apply, or 0 to leave the choice to the harness. Devcloud jobs and
+  // secondary -D backends get it in HFUZZ_KNOB instead of the record.
+  static int Knob() {
+    MetricsRecord &r = Get();
+    if (shared_) return r.knob;
+    const char *knob_str = getenv(kKnobEnvVar);
+    return knob_str ? atoi(knob_str) : 0;
+  }
+
+  // Kernel variant (1-based, see KernelVariants.hpp) the fuzzer wants this
+  // test case to run, or 0 if it does not fuzz the configuration. Comes
+  // from HFUZZ_VARIANT where there is no shm.
+  static int Variant() {
+    MetricsRecord &r = Get();
+    if (shared_) return r.variant;
+    const char *variant_str = getenv(kVariantEnvVar);
+    return variant_str ? atoi(variant_str) : 0;
+  }
+
+  // Seed for the test case's random choices (see Random.hpp), or 0 if the
+  // fuzzer did not pick one. Comes from HFUZZ_SEED where there is no shm.
+  static uint64_t Seed() {
+    MetricsRecord &r = Get();
+    if (shared_) return r.seed;
+    const char *seed_str = getenv(kSeedEnvVar);
+    return seed_str ? strtoull(seed_str, NULL, 10) : 0;
+  }
+
+  static MetricsRecord &Get() {
+    if (!rec_) {
+      const char *id_str = getenv(kMetricsEnvVar);
+      void *area = id_str ? shmat(atoi(id_str), NULL, 0) : (void *)-1;
+      if (area != (void *)-1) {
+        rec_ = (MetricsRecord *)area;
+        shared_ = true;
+      } else {
+        static MetricsRecord local;
+        rec_ = &local;
+      }
+    }
+    return *rec_;
+  }
+
+private:
+  static void Set(double &field, double v, uint32_t flag) {
+    MetricsRecord &r = Get();
+    r.magic = kMetricsMagic;
+    r.flags |= flag;
+    field = v;
+  }
+
+  static inline MetricsRecord *rec_{nullptr};
+  static inline bool shared_{false};
+};
+
+}  // namespace hfuzz
+
+#endif /* __METRICS_HPP__ */
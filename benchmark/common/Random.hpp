@@ -0,0 +1,58 @@
+#ifndef __RANDOM_HPP__
+#define __RANDOM_HPP__
+
+#include <cstdint>
+
+//
+// PCG32 random streams for harnesses and the kernels they launch.
+//
+// A harness seeds its generator from the fuzzer (hfuzz::Metrics::Seed()),
+// which logs the seed of every test case it keeps, so each of the
+// harness's choices can be replayed from the seed alone; there is no need
+// to log them from the harness. Inside a kernel, every work-item gets its
+// own stream of the same seed:
+//
+//   hfuzz::Rng rng(hfuzz::Metrics::Seed());
+//   uint64_t item_seed = rng.Next64();
+//   h.parallel_for(range<1>(n), [=](id<1> i) {
+//     hfuzz::Rng item(item_seed, i);
+//     float v = item.Uniform();
+//   });
+//
+// The class is trivially copyable and makes no library calls, so kernels
+// can capture it and construct it.
+//
+namespace hfuzz {
+
+class Rng {
+public:
+  explicit Rng(uint64_t seed, uint64_t stream = 0)
+      : state_(0), inc_(stream << 1 | 1) {
+    Next();
+    state_ += seed;
+    Next();
+  }
+
+  uint32_t Next() {
+    uint64_t old = state_;
+    state_ = old * 6364136223846793005ULL + inc_;
+    uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+    uint32_t rot = old >> 59;
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+  }
+
+  uint64_t Next64() { return uint64_t(Next()) << 32 | Next(); }
+
+  // Below n (n > 0), with the usual small modulo bias
+  uint32_t Below(uint32_t n) { return Next() % n; }
+
+  // Uniform in [0, 1)
+  float Uniform() { return (Next() >> 8) * (1.0f / 16777216.0f); }
+
+private:
+  uint64_t state_, inc_;
+};
+
+}  // namespace hfuzz
+
+#endif /* __RANDOM_HPP__ */
@@ -8,13 +8,21 @@
 // =============================================================
 
 #include <CL/sycl.hpp>
+#include <cstdlib>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <optional>
 #include <vector>
 
 // dpc_common.hpp can be found in the dev-utilities include folder.
 // e.g., $ONEAPI_ROOT/dev-utilities//include/dpc_common.hpp
 #include "dpc_common.hpp"
+#include "../common/ForkServer.hpp"
+#include "../common/HarnessPolicy.hpp"
+#include "../common/InputReader.hpp"
+#include "../common/Metrics.hpp"
+#include "../common/KernelVariants.hpp"
 #if FPGA || FPGA_EMULATOR
   #include <sycl/ext/intel/fpga_extensions.hpp>
 #endif
@@ -24,17 +32,40 @@ using namespace sycl;
 template <int unroll_factor>
 class VAdd;
 int k =0;
-// Adds corresponding elements of two input vectors using a loop. The loop is
-// unrolled as many times as specified by the unroll factor.
-template <int unroll_factor>
-void VectorAdd(queue &q, const vector<float> &a, const vector<float> &b,
-               vector<float> &sum) {
-  size_t n = a.size();
 
-  buffer buffer_a(a);
-  buffer buffer_b(b);
-  buffer buffer_sum(sum);
+// Test cases a persistent child runs before it is replaced by a fresh fork
+constexpr unsigned kPersistentCount = 1000;
+
+// What this build compiles in, see HarnessPolicy.hpp. Probes 1 reports the
+// number of wrong sums, probes 2 also the trip count of the unrolled loop
+// (full groups of 16 and the remainder). -DHFUZZ_ABORT_ON_MISMATCH=1 makes a
+// wrong sum a crash, as the old pipe_fuzz harnesses did. There is no device
+// mutation or side channel to switch
+using Harness = hfuzz::BuildPolicy;
+
+// Array size of an input that does not start with one; the pipe_fuzz
+// harnesses used 1 << 25
+#ifndef HFUZZ_LOOP_SIZE
+#define HFUZZ_LOOP_SIZE (1 << 15)
+#endif
+
+// Probe ids of the values reported to the fuzzer through hfuzz::Metrics
+enum { kProbeWrongSums, kProbeFullGroups, kProbeRemainder };
+
+// Unroll factors the binary is built with. The fuzzer picks one per test
+// case (hetero-fuzz -V 5); without a pick every test case runs them all
+using UnrollVariants =
+    hfuzz::KernelVariants<hfuzz::KernelConfig<1>, hfuzz::KernelConfig<2>,
+                          hfuzz::KernelConfig<4>, hfuzz::KernelConfig<8>,
+                          hfuzz::KernelConfig<16>>;
 
+// Adds corresponding elements of two input vectors using a loop. The loop is
+// unrolled as many times as specified by the unroll factor. The buffers may
+// be larger than the current input; only the first n elements are used.
+// Returns the kernel time in milliseconds.
+template <int unroll_factor>
+double VectorAdd(queue &q, buffer<float> &buffer_a, buffer<float> &buffer_b,
+               buffer<float> &buffer_sum, size_t n) {
   event e = q.submit([&](handler &h) {
     accessor acc_a(buffer_a, h, read_only);
     accessor acc_b(buffer_b, h, read_only);
@@ -60,6 +91,10 @@ void VectorAdd(queue &q, const vector<float> &a, const vector<float> &b,
   cout << "Throughput for kernel with unroll factor " << unroll_factor << ": ";
   cout << std::fixed << std::setprecision(3) << ((double)n / kernel_time) / 1e6f
        << " GFlops\n";
+
+  // Per-variant series for the fuzzer: unroll factor, kernel time
+  hfuzz::Metrics::Step(unroll_factor, kernel_time);
+  return kernel_time;
 }
 
 // Initialize vector.
@@ -80,6 +115,7 @@ void VerifyResults(const vector<float> &a, const vector<float> &b,
     if (sum[i] != a[i] + b[i]) {
         k = k+1;
       cout << "FAILED: The results are incorrect.\n";
+      if constexpr (Harness::kAbortOnMismatch) abort();
     }
   }
 }
@@ -87,15 +123,7 @@ void VerifyResults(const vector<float> &a, const vector<float> &b,
 int main(int argc, char* argv[]) {
   std::string file;
   if (argc > 1) file = argv[1];
-  std::ifstream read(file);
-    
-  if (!read.is_open()){
-      std::cout << "Could not open the input file.\n";
-  } 
-    
-  size_t n = 1 << 15;
-  read >> n;
-  cout << "Input array size: " << n << "\n";
+
 #if FPGA_EMULATOR
   // DPC++ extension: FPGA emulator selector on systems without FPGA card.
   ext::intel::fpga_emulator_selector d_selector;
@@ -106,24 +134,7 @@ int main(int argc, char* argv[]) {
   // The default device selector will select the most performant device.
   default_selector d_selector;
 #endif
-  // Input vectors.
-  vector<float> a(n);
-  vector<float> b(n);
-    
-  float number;
-  int i = 0;
-  while ((read >> number) and (i<n)){
-    a[i] = number;
-    i = i + 1;
-  }
-  i = 0;
-  while ((read >> number) and (i<n)){
-    b[i] = number;
-    i = i + 1;
-  }
-  read.close();
-  // Output vector.
-  vector<float> sum(n);
+  size_t n = HFUZZ_LOOP_SIZE;
 
   try {
     queue q(d_selector, dpc_common::exception_handler,
@@ -132,30 +143,100 @@ int main(int argc, char* argv[]) {
     cout << "Running on device: "
          << q.get_device().get_info<info::device::name>() << "\n";
 
-    // Instantiate VectorAdd kernel with different unroll factors: 1, 2, 4,
-    // 8, 16. The VectorAdd kernel contains a loop that adds corresponding
-    // elements of two input vectors. That loop is unrolled by the specified
-    // unroll factor.
-    VectorAdd<1>(q, a, b, sum);
-    VerifyResults(a, b, sum);
-    VectorAdd<2>(q, a, b, sum);
-    VerifyResults(a, b, sum);
-    VectorAdd<4>(q, a, b, sum);
-    VerifyResults(a, b, sum);
-    VectorAdd<8>(q, a, b, sum);
-    VerifyResults(a, b, sum);
-    VectorAdd<16>(q, a, b, sum);
-    VerifyResults(a, b, sum);
+    // Device buffers survive across test cases and are only reallocated
+    // when an input does not fit
+    size_t capacity = 0;
+    std::optional<buffer<float>> buffer_a, buffer_b, buffer_sum;
+
+    // Queue, buffers and compiled kernels stay alive across test cases: the
+    // first pass starts the fork server, every iteration runs one input
+    while (hfuzz::PersistentLoop(kPersistentCount)) {
+      hfuzz::InputReader read(file);
+
+      if (!read.is_open()){
+          std::cout << "Could not open the input file.\n";
+      } 
+
+      n = HFUZZ_LOOP_SIZE;
+      read >> n;
+      cout << "Input array size: " << n << "\n";
+      // Nothing to add, and no buffers to run on if this is the first input
+      if (n == 0) {
+        read.close();
+        hfuzz::Metrics::Flush();
+        continue;
+      }
+      // Input vectors.
+      vector<float> a(n);
+      vector<float> b(n);
+
+      // Whatever the input is short of keeps its zero
+      read.Read(a.data(), n);
+      read.Read(b.data(), n);
+      read.close();
+      // Output vector.
+      vector<float> sum(n);
+
+      if (n > capacity) {
+        buffer_a.emplace(range<1>(n));
+        buffer_b.emplace(range<1>(n));
+        buffer_sum.emplace(range<1>(n));
+        capacity = n;
+      }
+
+      q.submit([&](handler &h) {
+        accessor acc_a(*buffer_a, h, range<1>(n), write_only, no_init);
+        h.copy(a.data(), acc_a);
+      });
+      q.submit([&](handler &h) {
+        accessor acc_b(*buffer_b, h, range<1>(n), write_only, no_init);
+        h.copy(b.data(), acc_b);
+      });
+      auto read_sum = [&]() {
+        q.submit([&](handler &h) {
+          accessor acc_sum(*buffer_sum, h, range<1>(n), read_only);
+          h.copy(acc_sum, sum.data());
+        }).wait();
+      };
+
+      // Instantiate VectorAdd kernel with different unroll factors: 1, 2, 4,
+      // 8, 16. The VectorAdd kernel contains a loop that adds corresponding
+      // elements of two input vectors. That loop is unrolled by the specified
+      // unroll factor.
+      k = 0;
+      double total_time = 0;
+      auto run = [&](auto cfg) {
+        using Config = decltype(cfg);
+        total_time += VectorAdd<Config::kUnroll>(q, *buffer_a, *buffer_b,
+                                                 *buffer_sum, n);
+        read_sum();
+        VerifyResults(a, b, sum);
+      };
+      int variant = hfuzz::Metrics::Variant();
+      if (variant) UnrollVariants::Run(variant - 1, run);
+      else UnrollVariants::RunAll(run);
+
+      // The sums are what the fuzzer compares across backends (-D)
+      ofstream output("output.txt");
+      for (size_t i = 0; i < n; i++) output << sum[i] << "\n";
+      output.close();
+
+      // Kernel time of the variants run and the probes of this build
+      hfuzz::Metrics::SetExecTime(total_time);
+      hfuzz::Metrics::SetKernelTime(total_time * 1e-3);
+      if constexpr (Harness::kProbes >= 1)
+        hfuzz::Metrics::Probe(kProbeWrongSums, k);
+      if constexpr (Harness::kProbes >= 2) {
+        hfuzz::Metrics::Probe(kProbeFullGroups, n / 16);
+        hfuzz::Metrics::Probe(kProbeRemainder, n % 16);
+      }
+      hfuzz::Metrics::Flush();
+    }
 
   } catch (sycl::exception const &e) {
     cerr << "SYCL host exception:\n" << e.what() << "\n";
     terminate();
   }
-  std::ofstream outfile;
-  outfile.open("exec_fpga_info.txt");
-  outfile << n << std::endl <<  k << std::endl << k;
-  outfile.close();
-    
   cout << "PASSED: The results are correct.\n";
   return 0;
 }
@@ -0,0 +1,16 @@
+//==============================================================
+// Null target for the fuzzer's self-benchmark (fuzz -X): reads nothing,
+// runs nothing, so every microsecond an execution takes is the fuzzer's
+// own overhead plus process startup. Speaks the fork server protocol, so
+// the same binary measures the fork/execv path and the fork server path.
+//
+//   g++ -O2 -o null_target benchmark/null/null_target.cpp
+//   fuzz -X your_input_file_folder bench_out/ 1000 ./null_target
+//==============================================================
+
+#include "../common/ForkServer.hpp"
+
+int main(int argc, char* argv[]) {
+  hfuzz::StartForkServer();
+  return 0;
+}
@@ -0,0 +1,105 @@
+#!/bin/bash
+#
+# Content-addressed cache of compiled binaries: FPGA bitstreams, emulator
+# and GPU builds. Put it in front of a dpcpp command line:
+#
+#   ./build_cache.sh dpcpp -fintelfpga -Xshardware src/main.cpp \
+#       src/GSimulation.cpp -o nbody_hfuzz_probe.fpga
+#
+# If a binary was built before with the same key, it is copied to the -o
+# path and the compiler does not run. Otherwise the command runs and its
+# output is stored under the key. The key is a sha256 over:
+#  - every .cpp on the command line, preprocessed with the same flags, so
+#    header changes count and the file names do not;
+#  - the compiler's --version;
+#  - the flags except -o and the sources. Board (-Xsboard=...), -D options, -Xshardware
+#    and the like all select a different binary;
+#  - the board support package in use (AOCL_BOARD_PACKAGE_ROOT).
+#
+# The cache lives in $HFUZZ_BUILD_CACHE (default ~/.cache/hfuzz-build).
+# Point it at a shared directory so every fuzzing script and qsub job on
+# the cluster reuses the same builds. HFUZZ_BUILD_CACHE=off compiles
+# directly, without caching.
+#
+
+if [ $# -lt 2 ]; then
+  echo "Usage: $0 compiler [ flags ] sources... -o output" >&2
+  exit 1
+fi
+
+cc="$1"
+shift
+
+out=""
+flags=()
+sources=()
+while [ $# -gt 0 ]; do
+  case "$1" in
+    -o) out="$2"; shift 2; continue ;;
+    -o*) out="${1#-o}" ;;
+    *.cpp|*.cc|*.cxx) sources+=("$1"); flags+=("$1") ;;
+    *) flags+=("$1") ;;
+  esac
+  shift
+done
+
+if [ -z "$out" ] || [ ${#sources[@]} -eq 0 ]; then
+  echo "$0: need sources and -o output" >&2
+  exit 1
+fi
+
+if [ "$HFUZZ_BUILD_CACHE" = "off" ]; then
+  exec "$cc" "${flags[@]}" -o "$out"
+fi
+
+cache="${HFUZZ_BUILD_CACHE:-$HOME/.cache/hfuzz-build}"
+
+# Flags for the key: everything but the sources, which are keyed on their
+# contents. For preprocessing, also without the link-only options, which
+# -E has no use for
+key_flags=()
+pp_flags=()
+for f in "${flags[@]}"; do
+  case "$f" in
+    *.cpp|*.cc|*.cxx) continue ;;
+  esac
+  key_flags+=("$f")
+  case "$f" in
+    -l*|-L*|-Wl,*) ;;
+    *) pp_flags+=("$f") ;;
+  esac
+done
+
+key=$(
+  {
+    "$cc" --version 2>&1
+    printf '%s\n' "${key_flags[@]}"
+    echo "bsp=$AOCL_BOARD_PACKAGE_ROOT"
+    for src in "${sources[@]}"; do
+      # Line markers carry the paths, which must not change the key
+      if ! "$cc" "${pp_flags[@]}" -E -P "$src" 2>/dev/null; then
+        echo "$0: cannot preprocess $src, keying on its bytes" >&2
+        cat "$src"
+      fi
+    done
+  } | sha256sum | cut -d' ' -f1
+)
+
+entry="$cache/$key"
+
+if [ -f "$entry/binary" ]; then
+  echo "build cache: $out is $key"
+  cp -p "$entry/binary" "$out"
+  exit 0
+fi
+
+"$cc" "${flags[@]}" -o "$out" || exit $?
+
+# Stored under a temporary name and renamed, so that concurrent builds of
+# the same key never leave a partial entry behind
+mkdir -p "$cache"
+tmp=$(mktemp -d "$cache/.tmp.XXXXXX") || exit 0
+cp -p "$out" "$tmp/binary"
+printf '%s\n' "$cc" "${flags[@]}" > "$tmp/command"
+mv -T "$tmp" "$entry" 2>/dev/null || rm -rf "$tmp"
+echo "build cache: stored $out as $key"
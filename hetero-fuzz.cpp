@@ -20,6 +20,7 @@ extern "C" {
 
 #include <stdio.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
@@ -29,6 +30,7 @@ extern "C" {
 #include <fcntl.h>
 
 #include <string.h>
+#include <sched.h>
 
 #include <sys/time.h>
 #include <sys/resource.h>
@@ -36,6 +38,15 @@ extern "C" {
 #include <sys/wait.h>
 #include <sys/shm.h>
 #include <sys/ipc.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+
+#ifdef __AVX2__
+#  include <immintrin.h>
+#endif /* __AVX2__ */
 #ifdef __cplusplus
 }
 #endif
@@ -44,6 +55,20 @@ extern "C" {
 #include <string>
 #include <iostream>
 #include <fstream> 
+#include <unordered_map>
+#include <unordered_set>
+#include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+/* A number in a typed test case (see parse_typed()). */
+
+struct typed_value {
+  u8  type;                           /* T_I64 or T_F32                   */
+  s64 i;                              /* Value, if T_I64                  */
+  float f;                            /* Value, if T_F32                  */
+};
 
 static char in_dir[256];
 static char out_dir[256];
@@ -53,6 +78,8 @@ static long long end_time;
 struct queue_entry {
   char fname[256];                      /* File name for the test case      */
   u32 len;                            /* Input length                     */
+  u8* mem;                            /* Test case contents, cached       */
+  std::vector<struct typed_value>* typed; /* ... parsed, see parse_typed()  */
 
   u8  cal_failed,                     /* Calibration failed?              */
       trim_done,                      /* Trimmed?                         */
@@ -66,6 +93,8 @@ struct queue_entry {
   u32 bitmap_size,                    /* Number of bits set in bitmap     */
       exec_cksum;                     /* Checksum of the execution trace  */
 
+  u64 behavior;                       /* Trace + hardware, see behavior_key() */
+
   u64 exec_us,                        /* Execution time (us)              */
       handicap,                       /* Number of queue cycles behind    */
       depth;                          /* Path depth                       */
@@ -84,14 +113,23 @@ struct characteristic{
 };
 
 static std::vector<queue_entry*> input_queue; /* Fuzzing queue */
-std::vector<double> prob = {0.167, 0.167, 0.167, 0.167, 0.167, 0.167};  /*Probability vector*/
 
 static u8* trace_bits;                /* SHM with instrumentation bitmap  */
-static u8  total_bits[MAP_SIZE];     /* Up to now coverage */
+static u8  virgin_bits[MAP_SIZE];    /* Regions yet untouched by fuzzing */
+static u8  virgin_tmout[MAP_SIZE];   /* ... by any hang                  */
 static std::vector<characteristic*> divergence;  /* SHM with divergence*/
-static std::vector<bool> mut = {false,false,false,false,false,false}; 
 
 static int child_pid = -1;            /* PID of the fuzzed program        */
+static int forksrv_pid;               /* PID of the fork server           */
+
+#define EXEC_TMOUT_MULT 5             /* Timeout, in mean seed runs       */
+#define EXEC_TMOUT_MIN  1000          /* ... but at least (ms)            */
+#define EXEC_TMOUT_MAX  600000        /* ... and at most (ms)             */
+
+static u32 exec_tmout = EXEC_TMOUT_MAX; /* Timeout of a run (ms)         */
+static bool tmout_given;              /* -t                               */
+static s32 fsrv_ctl_fd,               /* Fork server control pipe (write) */
+           fsrv_st_fd;                /* Fork server status pipe (read)   */
 static int shm_id;                    /* SHM ID */
 static u16 count_class_lookup16[65536];
 static FILE* plot_file; 
@@ -99,25 +137,147 @@ static bool hardware_enabled = 0;     /*enable kernel simulation*/
 static bool devcloud_fpga_enable = 0; /*enable devcloud fpga simulation*/
 static bool devcloud_fpga_hd_enable = 1;
 static bool devcloud_gpu_enable = 0;  /*enable devcloud gpu*/
+static bool forkserver_mode = 0;      /*exec the target once, fork per input*/
+static bool debug_mode = 0;           /*log every iteration*/
+static bool bench_mode = 0;           /*-X: benchmark the fuzzer itself*/
+static bool binary_inputs = 0;        /*emit typed test cases as HFZB*/
+#define OPT_RESUME 0x100              /* getopt code of -resume           */
+
+static bool resume_mode = 0;          /*-resume: continue from a checkpoint*/
+static bool resumed = 0;              /*... and there was one*/
+static bool resume_import = 0;        /*re-running finds the checkpoint missed*/
+static u32 max_ulps = 4;              /*output comparison: ULP tolerance*/
+static double max_rel_err = 0;        /*... and relative tolerance*/
+static u32 max_hw_jobs = 8;           /*devcloud qsub jobs kept in flight*/
+static double explore_rate = 0.1;     /*share of filtered inputs run anyway*/
+static char* fpga_node_list = (char*)"s001-n085:ppn=2"; /*FPGA node pool*/
+static char* gpu_node_list = (char*)"1:gpu:ppn=2";      /*GPU node pool*/
+static char* backend_list;            /*-D: local backends to compare*/
+static char* target_path;             /*Path to the target binary*/
 static int current_max = 0;
-static double GFLOPS_max = 0;
-static double GFLOPS_min = 65536;
-static double DSP_min = 65536;
-static double DSP_max = 0;
-static double fmax_min = 65536;
-static double fmax_max = 0;
-static double time_max = 0;
 static int exec_time_max = 0;
-static int input_max = 0;
-static int input_min = 0;
 static float float_max = 655360000000;
 
+static u32 cur_hw_key;                /* Hardware metrics of the last run */
+
+/* Per-iteration logging, only with -d. */
+
+#define DEBUGF(x...) do { if (debug_mode) printf(x); } while (0)
+
+/* Dedup indexes: contents of every test case run so far, and behavior
+   (trace checksum + hardware metrics) of every test case kept so far,
+   with the number of clones we skipped for it. */
+
+static std::unordered_set<u64> seen_inputs;
+static std::unordered_map<u64, u32> seen_behavior;
+static u64 skipped_inputs, skipped_clones, skipped_hangs;
+
+static u64 input_key(const std::string &content);
+
+static struct queue_entry*            /* Fastest, smallest entry per byte */
+  top_rated[MAP_SIZE];
+static u32 edge_freq[MAP_SIZE];       /* Queue entries hitting each byte  */
+static bool score_changed;            /* top_rated changed, cull again    */
+static u32 queued_favored,            /* Entries marked favored           */
+           pending_favored;           /* ... not fuzzed yet               */
+static u64 queue_cycle;               /* Passes over the queue            */
+static u64 cur_exec_us;               /* Duration of the last execution   */
+static u64 total_exec_us;             /* Sum of exec_us over the queue    */
+static u64 total_bitmap_size;         /* Sum of bitmap_size               */
+static u32 total_cal_entries;         /* Entries timed so far             */
+
+/* Where the test case being run came from. Devcloud jobs keep a copy
+   until their results are in. */
+
+#define NO_PARENT 0xffffffff          /* Not mutated from a queue entry   */
+
+struct case_origin {
+  u32 id;                             /* Number in its file name          */
+  u32 parent;                         /* Queue index it was mutated from  */
+  u64 seed;                           /* Seed of its mutation stream      */
+  u64 depth;                          /* Depth of the parent              */
+  s32 host_arm, dev_arm;              /* Knobs used, -1 if none           */
+  s32 var_arm;                        /* Kernel variant, -1 if none       */
+};
+
+static const struct case_origin no_case = {0, NO_PARENT, 0, 0, -1, -1, -1};
+static struct case_origin cur_case = no_case;
+
+/* Random numbers, xoshiro256**. The worker stream (seeded from -s or
+   /dev/urandom, mixed with the sync ID so that every worker has its own)
+   makes the scheduling decisions and hands every test case a seed. The
+   mutators draw from a stream restarted from that seed, so a test case is
+   a function of its parent, its knob and its seed, which is all the
+   replay log needs to keep (see regenerate()). */
+
+static u64 rng_seed;                  /* -s, or from /dev/urandom         */
+static bool rng_seed_set;             /* ... -s given                     */
+static u64 rng_worker[4],             /* Worker stream                    */
+           rng_mut[4];                /* Mutation stream                  */
+
+static inline u64 rng_rotl(u64 x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+static inline u64 rng_next(u64* st) {
+
+  u64 ret = rng_rotl(st[1] * 5, 7) * 9;
+  u64 t = st[1] << 17;
+
+  st[2] ^= st[0];
+  st[3] ^= st[1];
+  st[1] ^= st[2];
+  st[0] ^= st[3];
+  st[2] ^= t;
+  st[3] = rng_rotl(st[3], 45);
+
+  return ret;
+
+}
+
+/* Expand a 64-bit seed into a stream state with splitmix64. */
+
+static void rng_init(u64* st, u64 seed) {
+
+  for (u32 i = 0; i < 4; i++) {
+    u64 z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    st[i] = z ^ (z >> 31);
+  }
+
+}
+
+/* A random number below limit, from the mutation stream. */
+
+static inline u32 UR(u32 limit) {
+  return rng_next(rng_mut) % limit;
+}
+
 static s32 out_fd,
            dev_urandom_fd = -1,
            out_dir_fd = -1,
            dev_null_fd = -1;
 
 static u8 *out_file;
+static s32 input_fd = -1;             /* memfd the target reads from      */
+static std::string input_path;        /* ... as a path for the target     */
+
+/* Local differential testing (-D). Every backend is its own build of the
+   target, <app>.<name>, and runs in its own working directory so that
+   the outputs and reports it writes there can't collide. */
+
+#define BACKEND_OUTPUT    "output.txt"      /* What the backends compare */
+
+struct local_backend {
+  std::string name;                   /* fpga_emu, fpga, gpu or cpu       */
+  std::string bin;                    /* <app>.<name>                     */
+  std::string dir;                    /* Working directory                */
+  pid_t pid;                          /* PID while running, else 0        */
+  u64 exec_ms;                        /* Latency of the last run          */
+};
+
+static std::vector<local_backend> backends;  /* -D, first is the reference */
 
 enum {
   /*00*/ NOT_INTEREST,
@@ -130,7 +290,8 @@ enum {
 enum {
   /* 00 */ FAULT_NONE,
   /* 01 */ FAULT_CRASH,
-  /* 02 */ FAULT_ERROR
+  /* 02 */ FAULT_ERROR,
+  /* 03 */ FAULT_TMOUT
 };
 
 /* Get unix time in milliseconds */
@@ -146,19 +307,462 @@ static u64 get_cur_time(void) {
 
 }
 
+/* Get unix time in microseconds. */
+
+static u64 get_cur_time_us(void) {
+
+  struct timeval tv;
+  struct timezone tz;
+
+  gettimeofday(&tv, &tz);
+
+  return (tv.tv_sec * 1000000ULL) + tv.tv_usec;
+
+}
+
+/* Get monotonic time in nanoseconds, for the self-benchmark. */
+
+static u64 get_cur_time_ns(void) {
+
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+
+}
+
+/* Telemetry. printf()s on every iteration cost real time on long
+   campaigns, so they only happen with -d (DEBUGF()). Instead, the fuzzing
+   loop times its stages and drops the samples into a single-producer,
+   single-consumer ring; a telemetry thread drains it into per-stage
+   latency histograms (log2 buckets of microseconds) and, every
+   TELEM_INTERVAL_MS, appends a line to out_dir/plot_data and redraws the
+   status screen. The totals are atomics the loop keeps up to date, see
+   telem_publish(). The loop never waits for the thread: when the ring is
+   full, samples are dropped. */
+
+#define TELEM_RING        4096        /* Samples in flight (power of 2)   */
+#define TELEM_BUCKETS     32          /* log2(us) histogram buckets       */
+#define TELEM_INTERVAL_MS 1000        /* plot_data and status screen      */
+#define TELEM_DRAIN_MS    50          /* Ring drain interval              */
+
+enum {
+  /* 00 */ STAGE_MUTATE,              /* mutate()                         */
+  /* 01 */ STAGE_DISPATCH,            /* Dedup, cache, filter, submission */
+  /* 02 */ STAGE_TARGET,              /* Target wall time                 */
+  /* 03 */ STAGE_METRICS,             /* Reading the metrics record       */
+  /* 04 */ STAGE_MERGE,               /* Classifying and merging coverage */
+  /* 05 */ STAGE_COUNT
+};
+
+static const char* stage_names[STAGE_COUNT] = {
+  "mutate", "dispatch", "target", "metrics", "merge"
+};
+
+struct telem_sample {
+  u32 stage;                          /* STAGE_*                          */
+  u32 us;                             /* Latency                          */
+};
+
+static struct telem_sample telem_ring[TELEM_RING];
+static std::atomic<u32> telem_head,   /* Next slot to write (loop)        */
+                        telem_tail;   /* Next slot to read (thread)       */
+
+static std::atomic<u64> telem_execs,  /* Target executions                */
+                        telem_dropped;/* Samples lost to a full ring      */
+static std::atomic<u32> telem_queue, telem_favored, telem_cycles,
+                        telem_cov, telem_hw_buckets, telem_crashes,
+                        telem_hangs;
+
+static std::thread telem_thread;
+static std::atomic<bool> telem_done;
+static bool telem_status;             /* Draw the status screen?          */
+static u64 telem_hist[STAGE_COUNT][TELEM_BUCKETS];  /* Thread only        */
+static u64 telem_start_time;
+
+/* Called by the fuzzing loop only. Every STAGE_TARGET sample is one
+   execution. */
+
+static inline void telem_record(u32 stage, u64 us) {
+
+  u32 head = telem_head.load(std::memory_order_relaxed);
+
+  if (stage == STAGE_TARGET) telem_execs.fetch_add(1, std::memory_order_relaxed);
+
+  if (head - telem_tail.load(std::memory_order_acquire) == TELEM_RING) {
+    telem_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  telem_ring[head % TELEM_RING] = {stage, (u32)MIN(us, 0xffffffffULL)};
+  telem_head.store(head + 1, std::memory_order_release);
+
+}
+
+static void telem_drain() {
+
+  u32 tail = telem_tail.load(std::memory_order_relaxed);
+  u32 head = telem_head.load(std::memory_order_acquire);
+
+  for (; tail != head; tail++) {
+
+    struct telem_sample* t = &telem_ring[tail % TELEM_RING];
+    u32 b = t->us ? 32 - __builtin_clz(t->us) : 0;
+
+    telem_hist[t->stage][MIN(b, TELEM_BUCKETS - 1)]++;
+
+  }
+
+  telem_tail.store(tail, std::memory_order_release);
+
+}
+
+/* Upper bound (us) of the histogram bucket holding quantile q. */
+
+static u64 telem_quantile(const u64* hist, double q) {
+
+  u64 total = 0, seen = 0;
+
+  for (u32 b = 0; b < TELEM_BUCKETS; b++) total += hist[b];
+  if (!total) return 0;
+
+  for (u32 b = 0; b < TELEM_BUCKETS; b++) {
+    seen += hist[b];
+    if (seen >= q * total) return 1ULL << b;
+  }
+
+  return 1ULL << (TELEM_BUCKETS - 1);
+
+}
+
+static void telem_show(u64 now, double eps) {
+
+  u32 cov = telem_cov.load(std::memory_order_relaxed);
+
+  SAYF(TERM_CLEAR cCYA "hetero-fuzz " cRST "(%s)\n\n", out_dir);
+
+  SAYF("        run time : %llu s\n", (now - telem_start_time) / 1000);
+  SAYF("           execs : %llu (%.1f/s)\n",
+       telem_execs.load(std::memory_order_relaxed), eps);
+  SAYF("           queue : %u entries, %u favored, %u cycles\n",
+       telem_queue.load(std::memory_order_relaxed),
+       telem_favored.load(std::memory_order_relaxed),
+       telem_cycles.load(std::memory_order_relaxed));
+  SAYF("        coverage : %u bytes (%.2f%% of the map)\n", cov,
+       cov * 100.0 / MAP_SIZE);
+  SAYF("hardware buckets : %u\n",
+       telem_hw_buckets.load(std::memory_order_relaxed));
+  SAYF("         crashes : %u\n",
+       telem_crashes.load(std::memory_order_relaxed));
+  SAYF("           hangs : %u (timeout %u ms)\n\n",
+       telem_hangs.load(std::memory_order_relaxed), exec_tmout);
+
+  SAYF("  stage        runs     p50 (us)     p99 (us)\n");
+
+  for (u32 i = 0; i < STAGE_COUNT; i++) {
+
+    u64 runs = 0;
+    for (u32 b = 0; b < TELEM_BUCKETS; b++) runs += telem_hist[i][b];
+
+    SAYF("  %-8s %8llu %12llu %12llu\n", stage_names[i], runs,
+         telem_quantile(telem_hist[i], 0.5), telem_quantile(telem_hist[i], 0.99));
+
+  }
+
+  u64 dropped = telem_dropped.load(std::memory_order_relaxed);
+  if (dropped) SAYF("\n  (%llu samples dropped)\n", dropped);
+
+  fflush(stdout);
+
+}
+
+/* One line of plot_data (and the status screen) for the last interval;
+   latencies are per interval, so the histograms start over. */
+
+static void telem_flush(u64 now, u64 last, u64* last_execs) {
+
+  u64 execs = telem_execs.load(std::memory_order_relaxed);
+  double eps = now > last ? (execs - *last_execs) * 1000.0 / (now - last) : 0;
+
+  *last_execs = execs;
+
+  if (plot_file) {
+
+    fprintf(plot_file, "%llu,%llu,%.2f,%u,%u,%u,%u,%u,%u,%u,%llu", now / 1000,
+            execs, eps, telem_queue.load(std::memory_order_relaxed),
+            telem_favored.load(std::memory_order_relaxed),
+            telem_cycles.load(std::memory_order_relaxed),
+            telem_cov.load(std::memory_order_relaxed),
+            telem_hw_buckets.load(std::memory_order_relaxed),
+            telem_crashes.load(std::memory_order_relaxed),
+            telem_hangs.load(std::memory_order_relaxed),
+            telem_dropped.load(std::memory_order_relaxed));
+
+    for (u32 i = 0; i < STAGE_COUNT; i++)
+      fprintf(plot_file, ",%llu,%llu", telem_quantile(telem_hist[i], 0.5),
+              telem_quantile(telem_hist[i], 0.99));
+
+    fprintf(plot_file, "\n");
+    fflush(plot_file);
+
+  }
+
+  if (telem_status) telem_show(now, eps);
+
+  memset(telem_hist, 0, sizeof(telem_hist));
+
+}
+
+static void telem_main() {
+
+  u64 last = get_cur_time(), last_execs = 0;
+
+  while (!telem_done.load(std::memory_order_acquire)) {
+
+    usleep(TELEM_DRAIN_MS * 1000);
+    telem_drain();
+
+    u64 now = get_cur_time();
+
+    if (now - last >= TELEM_INTERVAL_MS) {
+      telem_flush(now, last, &last_execs);
+      last = now;
+    }
+
+  }
+
+  telem_drain();
+  telem_flush(get_cur_time(), last, &last_execs);
+
+}
+
+/* Open plot_data and start the telemetry thread. Without a terminal, or
+   with -d, there is no status screen to draw. */
+
+static void telem_publish();
+
+static void telem_start() {
+
+  std::string fn = std::string(out_dir) + "plot_data";
+
+  /* A resumed campaign goes on in the same file. */
+
+  plot_file = fopen(fn.c_str(), resumed ? "a" : "w");
+  if (!plot_file) PFATAL("Unable to create '%s'", fn.c_str());
+
+  if (!resumed) {
+
+    fprintf(plot_file, "# unix_time,execs,execs_per_sec,queue,favored,cycles,"
+                       "cov_bytes,hw_buckets,crashes,hangs,dropped");
+
+    for (u32 i = 0; i < STAGE_COUNT; i++)
+      fprintf(plot_file, ",%s_p50_us,%s_p99_us", stage_names[i], stage_names[i]);
+
+    fprintf(plot_file, "\n");
+
+  }
+
+  telem_status = !debug_mode && isatty(1);
+  telem_start_time = get_cur_time();
+  telem_publish();
+  telem_thread = std::thread(telem_main);
+
+}
+
+static void telem_stop() {
+
+  if (!telem_thread.joinable()) return;
+
+  telem_done.store(1, std::memory_order_release);
+  telem_thread.join();
+
+  fclose(plot_file);
+  plot_file = NULL;
+
+}
+
 /* Display usage hints. */
 
 static void usage(char* argv0) {
 
-  SAYF("Usage: \n%s input_dir output_dir max_trials /path/to/fuzzed_app \n\n", argv0);
+  SAYF("Usage: \n%s [ options ] input_dir output_dir max_trials /path/to/fuzzed_app \n\n"
+
+       "Execution control settings:\n\n"
+
+       "  -F            - fork server mode: exec the target once and fork a copy\n"
+       "                  per input (implies local execution, no qsub jobs).\n"
+       "                  Targets using hfuzz::PersistentLoop() also reuse the\n"
+       "                  same child for many inputs.\n"
+       "  -D backends   - run the comma-separated local backends (fpga_emu,\n"
+       "                  fpga, gpu, cpu) concurrently and compare their\n"
+       "                  outputs; each is a build named app.<backend>\n"
+       "  -t msec       - timeout for each run (default: %ux the seeds' mean\n"
+       "                  run, within %u and %u ms)\n"
+       "  -E rate       - share of the test cases the selective-invocation\n"
+       "                  filter turns down that run anyway (default: %.2f)\n"
+       "  -K            - test cases with the same parsed values are the same\n"
+       "                  test case, for repeats and the result cache\n"
+       "  -d            - log every iteration instead of drawing the status\n"
+       "                  screen\n"
+       "  -P            - keep test cases in one packed corpus (corpus.dat and\n"
+       "                  corpus.idx) instead of a file each\n"
+       "  -x            - write the packed corpus of output_dir out as\n"
+       "                  individual files and exit\n"
+       "  -resume       - go on from the last checkpoint in output_dir\n"
+       "                  (written every minute and when stopped by a signal)\n"
+       "  -X            - benchmark the fuzzer itself against a null target\n"
+       "                  (max_trials rounds each) and write the results to\n"
+       "                  output_dir/self_bench.json\n\n"
+
+       "Mutation settings:\n\n"
+
+       "  -B            - write numeric test cases in the binary HFZB format\n"
+       "                  (see benchmark/common/InputReader.hpp)\n"
+       "  -V count      - also fuzz the kernel variant, one of the count\n"
+       "                  configurations the target registers\n"
+       "  -s seed       - seed the random number generator (default: random)\n"
+       "  -r id         - rebuild test case id of an earlier run from\n"
+       "                  output_dir/replay.bin and exit\n\n"
+
+       "Differential testing settings:\n\n"
+
+       "  -U ulps       - backend outputs agree within this many float ULPs\n"
+       "                  (default: %u)\n"
+       "  -R rel        - ... or within this relative error (default: off)\n\n"
+
+       "Parallel fuzzing settings:\n\n"
+
+       "  -M id         - main worker; output_dir becomes a sync dir shared\n"
+       "                  by all workers, findings go to output_dir/id/\n"
+       "  -S id         - secondary worker; like -M, but always runs the\n"
+       "                  target locally (only the main submits devcloud jobs)\n"
+       "  -b cpu        - bind the fuzzing process to this CPU core\n\n"
+
+       "Devcloud settings:\n\n"
+
+       "  -j jobs       - qsub jobs kept in flight (default: %u)\n"
+       "  -N nodes      - comma-separated FPGA node pool (default: %s)\n"
+       "  -G nodes      - comma-separated GPU node pool (default: %s)\n\n",
+       argv0, EXEC_TMOUT_MULT, EXEC_TMOUT_MIN, EXEC_TMOUT_MAX, explore_rate,
+       max_ulps, max_hw_jobs, fpga_node_list, gpu_node_list);
 
   exit(1);
 
 }
 
+/* Hardware metrics record, in a second shm segment next to the coverage
+   map. Harnesses fill it in through benchmark/common/Metrics.hpp; devcloud
+   jobs can't reach our shm and leave a copy in their job directory
+   instead. The layout must agree with hfuzz::MetricsRecord. */
+
+#define METRICS_ENV_VAR   "__HFUZZ_METRICS_ID"
+#define METRICS_FILE      "hfuzz_metrics.bin"
+#define METRICS_MAGIC     0x4d5a4648        /* "HFZM"                   */
+#define METRICS_PROBES    16
+#define METRICS_STEPS     256
+#define KNOB_ENV_VAR      "HFUZZ_KNOB"      /* Device knob without shm  */
+#define VARIANT_ENV_VAR   "HFUZZ_VARIANT"   /* ... kernel variant       */
+#define SEED_ENV_VAR      "HFUZZ_SEED"      /* ... and seed             */
+
+enum {
+  /* 01 */ M_EXEC_TIME = 1,
+  /* 02 */ M_DSPS      = 2,
+  /* 04 */ M_FMAX      = 4,
+  /* 08 */ M_GFLOPS    = 8,
+  /* 10 */ M_KERNEL_TIME = 16
+};
+
+struct hfuzz_metrics {
+  u32 magic,                          /* METRICS_MAGIC if written         */
+      flags,                          /* M_* for the scalars below        */
+      probe_mask,                     /* Valid entries of probe_min/max   */
+      n_steps,                        /* Entries used in the series       */
+      knob,                           /* Device knob to use (set by us)   */
+      variant;                        /* Kernel variant to run (by us)    */
+  u64 seed;                           /* Seed for the target's own RNG    */
+  double exec_time, dsps, fmax, gflops,
+         kernel_time;                 /* Device-profiled, in seconds      */
+  double probe_min[METRICS_PROBES], probe_max[METRICS_PROBES];
+  double step_time[METRICS_STEPS], step_value[METRICS_STEPS];
+};
+
+static struct hfuzz_metrics* metrics; /* SHM with the metrics record      */
+static int metrics_shm_id;            /* ... its SHM ID                   */
+
+static struct hfuzz_metrics last_metrics; /* Metrics of the last evaluation */
+static bool last_divergent;           /* ... and its divergence verdict   */
+static bool cache_replay;             /* Evaluating a result cache hit    */
+
+/* Hardware feedback works like coverage: every metric is quantized into
+   log-scale buckets, and reaching a bucket no test case reached before is
+   interesting, the same way a new edge is. On top of that, an archive in
+   the style of MAP-Elites keeps the slowest execution seen so far for every
+   combination of buckets of the other metrics (the cell); beating the
+   incumbent of a cell by HW_ELITE_MARGIN is interesting too.
+
+   The time we compete on is the device-profiled kernel time where the
+   harness reports one, the execution time otherwise (see hw_perf()).
+   Either is noisy, so a find that only rests on being slower is
+   calibrated before it is kept: see calibrate_case(). */
+
+#define HW_FEATURES     (4 + 2 * METRICS_PROBES)  /* Metrics with buckets  */
+#define HW_ELITE_MARGIN 1.05                      /* Needed to take a cell */
+
+static u8 hw_virgin[HW_FEATURES][256];  /* Buckets reached so far          */
+static u32 hw_buckets_hit;              /* ... how many                    */
+
+struct hw_elite {
+  double mean, var;                   /* Time of the incumbent, and its   */
+  u32 n;                              /* ... variance over n runs         */
+};
+
+static std::unordered_map<u64, struct hw_elite> hw_elites;  /* Cell -> time */
+
+/* What the last check_new_hardware() claimed on the strength of its time
+   alone, so that calibration can take it back. */
+
+static struct {
+  bool cell;                          /* Took over (or opened) a cell     */
+  u32 cell_id;                        /* ... which                        */
+  bool had_prev;                      /* ... it had an incumbent          */
+  struct hw_elite prev;               /* ... that one                     */
+  double perf;                        /* The time that did it             */
+  s32 time_bucket;                    /* New time bucket, or -1           */
+  bool other;                         /* Anything else made it interesting */
+} hw_claim;
+
+static u32 slow_rejected;             /* Slowdowns calibration disproved  */
+
+/* Append a test case to the queue, keeping its contents in memory so
+   that fuzzing never has to go back to the disk for it. */
+
+static struct queue_entry* add_to_queue(const std::string &fname,
+                                        const std::string &content) {
+
+  struct queue_entry *q = (struct queue_entry *)calloc(1, sizeof(queue_entry));
+
+  strncpy(q->fname, fname.c_str(), sizeof(q->fname) - 1);
+  q->len = content.size();
+  q->mem = (u8*)malloc(q->len + 1);
+  memcpy(q->mem, content.data(), q->len);
+  input_queue.push_back(q);
+
+  /* Mutations that reproduce a queued test case are not worth a run. */
+
+  seen_inputs.insert(input_key(content));
+
+  return q;
+
+}
+
+/* Queue every file in path, in name order so that queue indices (and
+   with them the replay log) don't depend on the order of readdir(). */
+
 static void list_dir(const char *path)
 {
     struct dirent *entry;
+    std::vector<std::string> names;
 
     DIR *dir = opendir(path);
     if (dir == NULL) {
@@ -168,14 +772,20 @@ static void list_dir(const char *path)
     while ((entry = readdir(dir)) != NULL) {
         if(entry->d_name[0]=='.')
             continue;
-        struct queue_entry *q = (struct queue_entry *)malloc(sizeof(queue_entry));
-        //q->fname = entry->d_name;
-        std::string file_name = std::string(path) + std::string(entry->d_name);
-        memcpy(q->fname, file_name.c_str(), strlen(file_name.c_str()));
-        input_queue.push_back(q);
+        names.push_back(entry->d_name);
     }
 
     closedir(dir);
+
+    std::sort(names.begin(), names.end());
+
+    for (auto &name : names) {
+        std::string file_name = std::string(path) + name;
+        std::ifstream ifs(file_name, std::ios::binary);
+        std::string content( (std::istreambuf_iterator<char>(ifs) ),
+                             (std::istreambuf_iterator<char>()    ) );
+        add_to_queue(file_name, content);
+    }
 }
 
 /* Make a copy of the current command line. */
@@ -206,34 +816,30 @@ static void save_cmdline(u32 argc, char** argv) {
 }
 
 std::string random_replace(const std::string &str) {
-  srand(time(NULL));
   int n = str.size();
-  int pos = rand() % n;
+  int pos = UR(n);
   char c = str[pos];
-  c ^= (1 << rand() % 7);
+  c ^= (1 << UR(7));
   std::string ret(str);
   ret[pos] = c;
   return ret;
 }
 
 std::string random_delete(const std::string &str) {
-  srand(time(NULL));
   int n = str.size();
-  int pos_e = rand() % n;
+  int pos_e = UR(n);
   
-  int pos_b = rand() % pos_e;
-  printf("delete position begin %d",pos_b);
-  printf("delete position end %d",pos_e);
+  int pos_b = UR(pos_e);
+  DEBUGF("delete position begin %d\n",pos_b);
+  DEBUGF("delete position end %d\n",pos_e);
   std::string ret(str);
   ret.erase(pos_b,pos_e-pos_b);
   return ret;
 }
 
 std::string random_append_number(const std::string &str) {
-  srand(time(NULL));
-  int a = rand();
   float num = float_max;
-  if (a%2==0){
+  if (UR(2)==0){
     num = -num;
   }
   std::string ret(str);
@@ -242,12 +848,11 @@ std::string random_append_number(const std::string &str) {
 }
 
 std::string random_add_sparsity(const std::string &str){
-  srand(time(NULL));
   std::string ret(str);
   for (int i = 0; i<ret.length();i++){
     if ('0'==ret[i]){
-      int num = rand()%10;
-      if (num >= rand()%10){
+      u32 num = UR(10);
+      if (num >= UR(10)){
         ret[i] = char(num+int('0'));
       }
     }
@@ -257,12 +862,11 @@ std::string random_add_sparsity(const std::string &str){
 }
 
 std::string random_reduce_sparsity(const std::string &str){
-  srand(time(NULL));
   std::string ret(str);
   for (int i = 0; i<ret.length();i++){
     if (ret[i]>'0'){
-      int num = rand()%10;
-      if (num >= rand()%10){
+      u32 num = UR(10);
+      if (num >= UR(10)){
         ret[i] = '0';
       }
     }
@@ -270,535 +874,4498 @@ std::string random_reduce_sparsity(const std::string &str){
   return ret;
 }
 
-/*mutation selection based the activation probabilities of each mutation*/
+/* Mutation operator scheduling. The host mutators (the knobs of
+   mutate()) and the device mutators (the knobs of the harness's
+   mutate(Particle&, knob, value)) are two multi-armed bandits, picked with
+   UCB1. An arm's value is its finds per test case over the mean time its
+   test cases took to run, so an operator that makes inputs ten times
+   slower to run has to find ten times as much to keep up, and one that
+   keeps producing repeats (which are never run) loses out too. The
+   device knob reaches the target in the metrics record (or in
+   KNOB_ENV_VAR, where there is no shm).
+
+   With -V, the kernel configurations the target registers
+   (benchmark/common/KernelVariants.hpp) are a third bandit, handed over
+   the same way in the record's variant field (or VARIANT_ENV_VAR). A test
+   case is then an input/configuration pair, and the variant is part of
+   its key (see case_key()). */
+
+#define HOST_ARMS 6                   /* Knobs of mutate()                */
+#define DEV_ARMS  4                   /* Device knobs, see Metrics::Knob() */
+#define MAX_VARIANTS 64               /* Most -V variants                 */
+
+static u32 num_variants;              /* -V, 0 if not fuzzing variants    */
+
+struct mut_arm {
+  u64 pulls;                          /* Test cases it produced           */
+  u64 runs;                           /* ... that were executed           */
+  u64 finds;                          /* ... that were interesting        */
+  double exec_s;                      /* Execution time of the runs       */
+};
+
+static inline double arm_value(const struct mut_arm* a) {
+
+  if (!a->runs || a->exec_s <= 0) return 0;
+
+  return ((double)a->finds / a->pulls) / (a->exec_s / a->runs);
 
-int selection(){
-    std::vector<int> prob_int;
-    int sum = 0;
-    for(int i=0;i<prob.size();i++) {
-        sum += prob[i]*100;
-        prob_int.push_back(sum);
-    }
-    int idx = rand()%100;
-    int ret = 0;
-    for (int i=0;i<prob_int.size();i++) {
-        if(prob_int[i]>=idx) {
-            ret = i;
-            break;
-        }
-    }
-    return ret;
 }
 
-std::string mutate(int fuzzing_iteration, std::string current_input){
+static struct mut_arm host_arms[HOST_ARMS], dev_arms[DEV_ARMS],
+                      var_arms[MAX_VARIANTS];
 
-  //printf("current input: %s\n", current_input.c_str());
+/* UCB1 over arm_value(), normalized to the best arm so far. Arms that
+   were never pulled go first. */
 
-  std::ifstream ifs(current_input);
-  std::string content( (std::istreambuf_iterator<char>(ifs) ),
-                       (std::istreambuf_iterator<char>()    ) );
+static u32 pick_arm(const struct mut_arm* arms, u32 n) {
 
-  srand(time(NULL) + rand());
+  u64 total = 0;
+  double best_rate = 0, best_score = -1;
+  u32 best = 0;
 
-  int knob = rand()%6+1;
-  std::cout << knob << std::endl;
-  if(knob == 1){
-    srand(time(0) + rand());
-    int pos = rand()%(content.length()-1); //TBD: modify, only change the matrix element
-    u8 new_value = rand()%256;
-    while (isdigit(content[pos])==0){
-      pos = rand()%(content.length()-1);
-    }
-    printf("selected pos: %d\n", pos);
-    content[pos] = new_value;
-  }
-  else if(knob == 2){
-    content = random_append_number(content);
-  }
-  else if(knob == 3){
-    content = random_add_sparsity(content);
-  }
-  else if(knob == 4){
-    int pos = rand()%(content.length()-1);
-    u8 new_value = '/n';
-    content[pos] = new_value;
-  }else if(knob == 5){
-    content = random_delete(content);
-  }
-  else if(knob == 6){
-    content = random_reduce_sparsity(content);
+  for (u32 i = 0; i < n; i++) {
+    if (!arms[i].pulls) return i;
+    total += arms[i].pulls;
+    if (arm_value(&arms[i]) > best_rate) best_rate = arm_value(&arms[i]);
   }
 
+  for (u32 i = 0; i < n; i++) {
 
-  std::string mutated_input = std::string(out_dir) + std::to_string(fuzzing_iteration);
-  //printf("%s\n", mutated_input.c_str());
-  std::ofstream out(mutated_input);
-  out << content;
-  out.close();
-  return mutated_input;
-}
+    double rate = arm_value(&arms[i]);
+    double score = (best_rate > 0 ? rate / best_rate : 0) +
+                   sqrt(2 * log((double)total) / arms[i].pulls);
 
+    if (score > best_score) {
+      best_score = score;
+      best = i;
+    }
 
-int devcloud_fpga_exec(char* app, char* argv[]){
-  int a;
-  char* execute = "env BITSTREAM=a.aocx INTEL_FPGA_OCL_PLATFORM_NAME=\"$HW_PLATFORM\" AOC_OPTION=\"-board=$FPGA_BOARD\" ./";
-  strcat(execute,app);
-  strcat(execute," ");
-  strcat(execute,argv[1]);
-  a = std::system(execute);
-  if (a<0){
-    perror("Run error: error when run the host on fpga");
-    exit(EXIT_FAILURE);
-  }
-  else {
-    printf("succuess!\n");
   }
 
-  return 0;
+  return best;
+
 }
 
-int run_target(char* app, char mutated_input[]){
-  int status = 0;
-  memset(trace_bits, 0, MAP_SIZE);
+/* Credit the arms behind test case c with its outcome; exec_us is 0 for
+   test cases that were not run. */
 
-  // u32 ck2 = hash32(trace_bits, MAP_SIZE, HASH_CONST);
-  // SAYF("check sum of 0 bitmap %u\n", ck2);
+static void reward_arms(const struct case_origin &c, bool found, u64 exec_us) {
 
-  char* argv[] = {app, mutated_input, NULL};
+  struct mut_arm* arms[] = {c.host_arm >= 0 ? &host_arms[c.host_arm] : NULL,
+                            c.dev_arm >= 0 ? &dev_arms[c.dev_arm] : NULL,
+                            c.var_arm >= 0 ? &var_arms[c.var_arm] : NULL};
 
-  child_pid = fork();
-  if(child_pid < 0){
-    perror("fork error.");
-    exit(EXIT_FAILURE);
+  for (auto a : arms) {
+    if (!a) continue;
+    a->pulls++;
+    a->runs += exec_us > 0;
+    a->finds += found;
+    a->exec_s += exec_us / 1e6;
   }
 
-  //std::string temp_simulation = "env BITSTREAM=a.aocx CL_CONTEXT_EMULATOR_DEVICE_INTELFPGA=1 INTEL_FPGA_OCL_PLATFORM_NAME=\"$EMULATOR_PLATFORM\" ./" + std::string(app) + std::string(" ") + std::string(argv[1]);
-  //std::string temp_fpga = "env BITSTREAM=a.aocx INTEL_FPGA_OCL_PLATFORM_NAME=\"$HW_PLATFORM\" AOC_OPTION=\"-board=$FPGA_BOARD\" ./" + std::string(app) + std::string(" ") + std::string(argv[1]);
-  std::string temp_fpga = "qsub -l nodes=s001-n085:ppn=2 " + std::string(app) + std::string("-fpga.sh -v ") + std::string(argv[1]);
-  std::string temp_gpu = "qsub -l nodes=1:gpu:ppn=2 " + std::string(app) + std::string("-gpu.sh -v ") + std::string(argv[1]);
-  const char* execute = NULL;
-  if (devcloud_fpga_enable) {
-    execute = temp_fpga.c_str();
-  }
-  if (devcloud_fpga_hd_enable){
-    execute = temp_fpga.c_str();
-  }
-  printf("%s",execute);
-  if(!child_pid){ // This is a child process
-    if (devcloud_fpga_enable) {
-      //devcloud_fpga_simulation_exec(app,argv);
-      
-      int a = std::system(temp_fpga.c_str());
-      a = std::system(temp_gpu.c_str());
-    }
-    else if (devcloud_fpga_hd_enable){
-      int a = std::system(temp_fpga.c_str());
-      a = std::system(temp_gpu.c_str());
-    }
-    else {
-      execv(app, argv);
-      //int a = std::system(execute);
-    }
-    *(u32*)trace_bits = EXEC_FAIL_SIG;
-    exit(0);
-  }
-  sleep(30);
+}
 
-  pid_t ret;
-  ret = waitpid(child_pid, &status, 0);
-  if(ret < 0){
-    perror("wait error");
+static void show_arms(const char* name, const struct mut_arm* arms, u32 n) {
+
+  std::string line;
+
+  for (u32 i = 0; i < n; i++)
+    line += " " + std::to_string(i + 1) + ":" + std::to_string(arms[i].finds) +
+            "/" + std::to_string(arms[i].pulls);
+
+  OKF("%s knobs (finds/runs):%s", name, line.c_str());
+
+}
+
+/* Typed mutation. Benchmark inputs are whitespace-separated ints and
+   floats, so byte-level edits of the text mostly produce inputs that fail
+   to parse or parse to the same values. Instead, a test case is parsed
+   once into typed values, mutated value by value, and written back either
+   as text or in HFZB, a binary format the harnesses load directly
+   (benchmark/common/InputReader.hpp):
+
+     "HFZB"  u32 run_cnt
+     run_cnt x { u32 type, u32 count, count x s64 (T_I64) or float (T_F32) }
+
+   All fields are little-endian. HFZB can carry NaN, Inf and denormals
+   exactly, which text can't portably. */
+
+enum {
+  /* 00 */ T_I64,
+  /* 01 */ T_F32
+};
+
+#define HFZB_MAGIC "HFZB"
+
+static inline bool is_hfzb(const std::string &content) {
+  return content.size() >= 8 && !memcmp(content.data(), HFZB_MAGIC, 4);
+}
+
+/* Decode an HFZB test case. Returns false if it is malformed. */
+
+static bool parse_hfzb(const std::string &content, std::vector<typed_value> &out) {
+
+  const u8* ptr = (const u8*)content.data() + 4;
+  const u8* end = (const u8*)content.data() + content.size();
+  u32 run_cnt, type, count;
+
+  memcpy(&run_cnt, ptr, 4);
+  ptr += 4;
+
+  while (run_cnt--) {
+
+    if (end - ptr < 8) return false;
+
+    memcpy(&type, ptr, 4);
+    memcpy(&count, ptr + 4, 4);
+    ptr += 8;
+
+    if (type > T_F32) return false;
+
+    u32 size = type == T_I64 ? 8 : 4;
+
+    if ((u64)(end - ptr) < (u64)count * size) return false;
+
+    while (count--) {
+      typed_value v = {(u8)type, 0, 0};
+      if (type == T_I64) memcpy(&v.i, ptr, 8);
+      else memcpy(&v.f, ptr, 4);
+      out.push_back(v);
+      ptr += size;
+    }
+
+  }
+
+  return true;
+
+}
+
+/* Parse a test case into typed values: HFZB, or text where every token is
+   an integer or a float. Leaves out empty if the test case is neither. */
+
+static void parse_typed(const std::string &content, std::vector<typed_value> &out) {
+
+  out.clear();
+
+  if (is_hfzb(content)) {
+    if (!parse_hfzb(content, out)) out.clear();
+    return;
+  }
+
+  const char* ptr = content.c_str();
+
+  while (1) {
+
+    char* end;
+    typed_value v = {T_I64, 0, 0};
+
+    while (isspace(*ptr)) ptr++;
+    if (!*ptr) break;
+
+    v.i = strtoll(ptr, &end, 10);
+
+    if (end == ptr || (*end && !isspace(*end))) {
+
+      v.type = T_F32;
+      v.f = strtof(ptr, &end);
+
+      if (end == ptr || (*end && !isspace(*end))) {
+        out.clear();
+        return;
+      }
+
+    }
+
+    out.push_back(v);
+    ptr = end;
+
+  }
+
+}
+
+static std::string emit_typed(const std::vector<typed_value> &vals, bool binary) {
+
+  std::string ret;
+
+  if (!binary) {
+
+    char buf[32];
+
+    for (auto &v : vals) {
+      if (v.type == T_I64) snprintf(buf, sizeof(buf), "%lld ", (long long)v.i);
+      else snprintf(buf, sizeof(buf), "%.9g ", v.f);
+      ret += buf;
+    }
+
+    if (!ret.empty()) ret.back() = '\n';
+    return ret;
+
+  }
+
+  /* Consecutive values of the same type share a run. */
+
+  u32 run_cnt = 0;
+
+  ret = HFZB_MAGIC;
+  ret.append(4, 0);
+
+  for (size_t i = 0; i < vals.size(); ) {
+
+    size_t j = i;
+    while (j < vals.size() && vals[j].type == vals[i].type) j++;
+
+    u32 type = vals[i].type, count = j - i;
+
+    ret.append((char*)&type, 4);
+    ret.append((char*)&count, 4);
+
+    for (; i < j; i++) {
+      if (type == T_I64) ret.append((char*)&vals[i].i, 8);
+      else ret.append((char*)&vals[i].f, 4);
+    }
+
+    run_cnt++;
+
+  }
+
+  memcpy(&ret[4], &run_cnt, 4);
+  return ret;
+
+}
+
+/* Values worth trying: IEEE corner cases and the int boundaries that tend
+   to end up as sizes and loop bounds. */
+
+static const float interesting_f32[] = {
+  NAN, INFINITY, -INFINITY, FLT_MAX, -FLT_MAX, FLT_MIN, FLT_MIN / 2,
+  FLT_TRUE_MIN, 0.0f, -0.0f, 1.0f, -1.0f, 655360000000.0f /* float_max */
+};
+
+static const s64 interesting_i64[] = {
+  0, 1, -1, 16, 32, 64, 100, 127, 128, 255, 256, 512, 1000, 1024, 4096,
+  32767, 65535, 65536, 100663045, 2147483647, -2147483648LL
+};
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
+
+/* Apply one value-level mutation. */
+
+static void mutate_typed(std::vector<typed_value> &vals, int knob) {
+
+  size_t n = vals.size();
+  size_t pos = UR(n);
+  typed_value &v = vals[pos];
+  u32 bits;
+
+  DEBUGF("typed mutation %d at value %zu\n", knob, pos);
+
+  switch (knob) {
+
+    case 1: /* Flip a mantissa bit / a low bit: small change in value */
+
+      if (v.type == T_F32) {
+        memcpy(&bits, &v.f, 4);
+        bits ^= 1u << UR(23);
+        memcpy(&v.f, &bits, 4);
+      } else v.i ^= 1LL << UR(8);
+      break;
+
+    case 2: /* Flip an exponent bit / a high bit: change in magnitude */
+
+      if (v.type == T_F32) {
+        memcpy(&bits, &v.f, 4);
+        bits ^= 1u << (23 + UR(8));
+        memcpy(&v.f, &bits, 4);
+      } else v.i ^= 1LL << (8 + UR(55));
+      break;
+
+    case 3: /* Interesting values */
+
+      if (v.type == T_F32)
+        v.f = interesting_f32[UR(ARRAY_LEN(interesting_f32))];
+      else
+        v.i = interesting_i64[UR(ARRAY_LEN(interesting_i64))];
+      break;
+
+    case 4: /* Sign flip */
+
+      if (v.type == T_F32) v.f = -v.f;
+      else v.i = (s64)(0 - (u64)v.i);   /* INT64_MIN stays itself       */
+      break;
+
+    case 5: { /* Zero a span: sparsity */
+
+        size_t len = 1 + UR(n / 4 + 1);
+        for (size_t i = pos; i < n && i < pos + len; i++) {
+          vals[i].i = 0;
+          vals[i].f = 0;
+        }
+        break;
+
+      }
+
+    case 6: { /* Grow or shrink the input */
+
+        if (UR(2) || n == 1) {
+          typed_value nv = {T_F32, 0, float_max};
+          if (UR(2)) nv.f = -nv.f;
+          vals.insert(vals.begin() + UR(n + 1), nv);
+        } else {
+          size_t len = 1 + UR(n / 4 + 1);
+          if (pos + len > n) len = n - pos;
+          if (len == n) len = n - 1;
+          vals.erase(vals.begin() + pos, vals.begin() + pos + len);
+        }
+        break;
+
+      }
+
+  }
+
+}
+
+/* Mutate a queue entry with the given knob, drawing from the mutation
+   stream. Returns the new contents, the test case only hits the disk if
+   it turns out to be worth keeping (see write_to_test()). Numeric test
+   cases get typed mutations; anything else falls back to the text
+   mutations. */
+
+std::string mutate(struct queue_entry* q, int knob){
+
+  std::string content((char*)q->mem, q->len);
+
+  DEBUGF("mutating %s with knob %d\n", q->fname, knob);
+
+  if (!q->typed) {
+    q->typed = new std::vector<typed_value>;
+    parse_typed(content, *q->typed);
+  }
+
+  if (!q->typed->empty()) {
+    std::vector<typed_value> vals(*q->typed);
+    mutate_typed(vals, knob);
+    return emit_typed(vals, binary_inputs || is_hfzb(content));
+  }
+
+  if(knob == 1){
+    int pos = UR(content.length()-1); //TBD: modify, only change the matrix element
+    u8 new_value = UR(256);
+    while (isdigit(content[pos])==0){
+      pos = UR(content.length()-1);
+    }
+    DEBUGF("selected pos: %d\n", pos);
+    content[pos] = new_value;
+  }
+  else if(knob == 2){
+    content = random_append_number(content);
+  }
+  else if(knob == 3){
+    content = random_add_sparsity(content);
+  }
+  else if(knob == 4){
+    int pos = UR(content.length()-1);
+    u8 new_value = '/n';
+    content[pos] = new_value;
+  }else if(knob == 5){
+    content = random_delete(content);
+  }
+  else if(knob == 6){
+    content = random_reduce_sparsity(content);
+  }
+
+  return content;
+}
+
+
+int devcloud_fpga_exec(char* app, char* argv[]){
+  int a;
+  char* execute = "env BITSTREAM=a.aocx INTEL_FPGA_OCL_PLATFORM_NAME=\"$HW_PLATFORM\" AOC_OPTION=\"-board=$FPGA_BOARD\" ./";
+  strcat(execute,app);
+  strcat(execute," ");
+  strcat(execute,argv[1]);
+  a = std::system(execute);
+  if (a<0){
+    perror("Run error: error when run the host on fpga");
     exit(EXIT_FAILURE);
   }
-  
-  int tb4 = *(u32*)trace_bits;
+  else {
+    printf("succuess!\n");
+  }
+
+  return 0;
+}
+
+/* Test cases are handed to the target through a memfd: we rewrite it in
+   place and the target opens it as /dev/fd/N, which it inherits. When
+   memfd_create() is not available, fall back to a regular file in the
+   output dir. */
+
+static void setup_input_fd() {
+
+#ifdef MFD_CLOEXEC
+
+  input_fd = memfd_create("hfuzz-input", 0);
+
+  if (input_fd >= 0) {
+    input_path = "/dev/fd/" + std::to_string(input_fd);
+    return;
+  }
+
+#endif /* MFD_CLOEXEC */
+
+  input_path = std::string(out_dir) + ".cur_input";
+  input_fd = open(input_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+  if (input_fd < 0) PFATAL("Unable to create '%s'", input_path.c_str());
+
+}
+
+/* Replace the contents of the file the target reads. */
+
+static void write_test_case(const std::string &content) {
+
+  if (ftruncate(input_fd, 0)) PFATAL("ftruncate() failed");
+
+  if (pwrite(input_fd, content.data(), content.size(), 0) != (ssize_t)content.size())
+    PFATAL("Short write to '%s'", input_path.c_str());
+
+}
+
+/* Timeouts. Nothing stops an input from sending the target into an
+   endless loop, or from blocking it on a pipe read that never completes;
+   without a limit, one such input would stall the campaign for the rest
+   of its walltime. Every local run gets exec_tmout ms. Unless -t fixes
+   it, that is EXEC_TMOUT_MULT times the mean execution time of the seeds,
+   measured in the dry run, within EXEC_TMOUT_MIN and EXEC_TMOUT_MAX. The
+   dry run itself gets EXEC_TMOUT_MAX.
+
+   On a timeout, SIGALRM kills the process group of every child we are
+   waiting for. Targets run in their own group, so that helpers the SYCL
+   runtime started go with them. The input is a hang; hangs are kept
+   like crashes, but only if their trace adds to what the earlier hangs
+   covered (see save_hang()). */
+
+static volatile sig_atomic_t child_timed_out; /* Last run was killed      */
+static u32 prev_timed_out;            /* ... tell the fork server         */
+static volatile sig_atomic_t stop_soon;       /* SIGINT, SIGTERM or SIGHUP */
+
+static void kill_group(pid_t pid) {
+
+  if (pid <= 0) return;
+
+  /* A child that did not get to setpgid() yet has no group. */
+
+  kill(-pid, SIGKILL);
+  kill(pid, SIGKILL);
+
+}
+
+static void handle_timeout(int sig) {
+
+  child_timed_out = 1;
+
+  kill_group(child_pid);
+  for (auto &b : backends) kill_group(b.pid);
+
+}
+
+/* A walltime limit or a Ctrl-C: finish the run in progress, write a
+   checkpoint and exit (see save_state()). */
+
+static void handle_stop_sig(int sig) {
+
+  stop_soon = 1;
+
+}
+
+static void setup_signal_handlers() {
+
+  struct sigaction sa;
+
+  memset(&sa, 0, sizeof(sa));
+  sigemptyset(&sa.sa_mask);
+
+  /* waitpid() and the fork server reads just go on and collect the
+     killed child. */
+
+  sa.sa_flags = SA_RESTART;
+  sa.sa_handler = handle_timeout;
+  sigaction(SIGALRM, &sa, NULL);
+
+  sa.sa_handler = handle_stop_sig;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  sigaction(SIGHUP, &sa, NULL);
+
+}
+
+static void arm_timeout(u32 ms) {
+
+  struct itimerval it;
+
+  memset(&it, 0, sizeof(it));
+  it.it_value.tv_sec = ms / 1000;
+  it.it_value.tv_usec = (ms % 1000) * 1000;
+
+  child_timed_out = 0;
+  setitimer(ITIMER_REAL, &it, NULL);
+
+}
+
+static void disarm_timeout() {
+
+  struct itimerval it;
+
+  memset(&it, 0, sizeof(it));
+  setitimer(ITIMER_REAL, &it, NULL);
+
+}
+
+/* After the dry run: scale the timeout to the seeds. */
+
+static void set_exec_timeout() {
+
+  u64 total_us = 0;
+  u32 n = 0;
+
+  if (tmout_given) return;
+
+  for (auto q : input_queue)
+    if (q->exec_us) {
+      total_us += q->exec_us;
+      n++;
+    }
+
+  if (!n) return;
+
+  u64 ms = total_us / n * EXEC_TMOUT_MULT / 1000;
+  exec_tmout = MIN(MAX(ms, (u64)EXEC_TMOUT_MIN), (u64)EXEC_TMOUT_MAX);
+
+  OKF("Timeout is %u ms (%ux the mean seed run of %llu ms).", exec_tmout,
+      EXEC_TMOUT_MULT, total_us / n / 1000);
+
+}
+
+/* Spin up the fork server. The target is exec'd once with a fixed input
+   path; it is expected to stop at a point where the SYCL runtime and the
+   device selector are already initialized (see benchmark/common/ForkServer.hpp)
+   and then fork a fresh copy whenever we write to the control pipe. This is
+   the same protocol as AFL's, so AFL-instrumented targets work as well. */
+
+static void init_forkserver(char* app) {
+
+  int st_pipe[2], ctl_pipe[2];
+  int status;
+  s32 rlen;
+
+  ACTF("Spinning up the fork server...");
+
+  if (pipe(st_pipe) || pipe(ctl_pipe)) PFATAL("pipe() failed");
+
+  forksrv_pid = fork();
+
+  if (forksrv_pid < 0) PFATAL("fork() failed");
+
+  if (!forksrv_pid) {
+
+    char* argv[] = {app, (char*)input_path.c_str(), NULL};
+
+    /* Isolate the process so that our signals don't reach it. */
+
+    setsid();
+
+    if (dup2(ctl_pipe[0], FORKSRV_FD) < 0) PFATAL("dup2() failed");
+    if (dup2(st_pipe[1], FORKSRV_FD + 1) < 0) PFATAL("dup2() failed");
+
+    close(ctl_pipe[0]);
+    close(ctl_pipe[1]);
+    close(st_pipe[0]);
+    close(st_pipe[1]);
+
+    execv(app, argv);
+
+    /* Use a distinctive bitmap signature to tell the parent about execv()
+       falling through. */
+
+    *(u32*)trace_bits = EXEC_FAIL_SIG;
+    exit(0);
+
+  }
+
+  /* Close the unneeded endpoints. */
+
+  close(ctl_pipe[0]);
+  close(st_pipe[1]);
+
+  fsrv_ctl_fd = ctl_pipe[1];
+  fsrv_st_fd  = st_pipe[0];
+
+  /* The target says hello with four bytes once it reaches its fork point.
+     If it never does, it is either not fork server aware or it crashed. */
+
+  rlen = read(fsrv_st_fd, &status, 4);
+
+  if (rlen == 4) {
+    OKF("All right - fork server is up.");
+    return;
+  }
+
+  if (waitpid(forksrv_pid, &status, 0) <= 0)
+    PFATAL("waitpid() failed");
+
+  if (*(u32*)trace_bits == EXEC_FAIL_SIG)
+    FATAL("Unable to execute target application ('%s')", app);
+
+  if (WIFSIGNALED(status))
+    FATAL("Fork server crashed with signal %d", WTERMSIG(status));
+
+  FATAL("Fork server handshake failed (is the target calling "
+        "hfuzz::StartForkServer()?)");
+
+}
+
+/* Run the current test case through the fork server. */
+
+static int run_forkserver_target() {
+
+  int status = 0;
+  s32 res;
+
+  /* If the last child was killed just as it parked itself in SIGSTOP, the
+     fork server needs to reap it rather than resume it. */
+
+  if ((res = write(fsrv_ctl_fd, &prev_timed_out, 4)) != 4)
+    RPFATAL(res, "Unable to request new process from fork server (OOM?)");
+
+  if ((res = read(fsrv_st_fd, &child_pid, 4)) != 4)
+    RPFATAL(res, "Unable to request new process from fork server (OOM?)");
+
+  if (child_pid <= 0) FATAL("Fork server is misbehaving (OOM?)");
+
+  arm_timeout(exec_tmout);
+  res = read(fsrv_st_fd, &status, 4);
+  disarm_timeout();
+
+  if (res != 4) RPFATAL(res, "Unable to communicate with fork server");
+
+  if (!WIFSTOPPED(status)) child_pid = 0;
+
+  prev_timed_out = child_timed_out;
+  if (child_timed_out) return FAULT_TMOUT;
+
+  if (WIFSIGNALED(status)) {
+    DEBUGF("child exited abnormal signal number= %d \n", WTERMSIG(status));
+    return FAULT_CRASH;
+  }
+
+  if (*(u32*)trace_bits == EXEC_FAIL_SIG) return FAULT_ERROR;
+
+  return FAULT_NONE;
+
+}
+
+int run_target(char* app, const std::string &content){
+  int status = 0;
+  memset(trace_bits, 0, MAP_SIZE);
+  memset(metrics, 0, sizeof(*metrics));
+  metrics->knob = cur_case.dev_arm + 1;
+  metrics->variant = cur_case.var_arm + 1;
+  metrics->seed = cur_case.seed;
+  write_test_case(content);
+
+  if (forkserver_mode) return run_forkserver_target();
+
+  // u32 ck2 = hash32(trace_bits, MAP_SIZE, HASH_CONST);
+  // SAYF("check sum of 0 bitmap %u\n", ck2);
+
+  char* argv[] = {app, (char*)input_path.c_str(), NULL};
+
+  child_pid = fork();
+  if(child_pid < 0){
+    perror("fork error.");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Hardware runs on devcloud nodes go through the job scheduler, see
+     hw_dispatch(). Here we only ever run the target locally. */
+
+  if(!child_pid){ // This is a child process
+    setpgid(0, 0);
+    execv(app, argv);
+    *(u32*)trace_bits = EXEC_FAIL_SIG;
+    exit(0);
+  }
+
+  pid_t ret;
+  arm_timeout(exec_tmout);
+  ret = waitpid(child_pid, &status, 0);
+  disarm_timeout();
+  if(ret < 0){
+    perror("wait error");
+    exit(EXIT_FAILURE);
+  }
+  
+  int tb4 = *(u32*)trace_bits;
+
+  DEBUGF("check sum of changed bitmap %u\n", hash32(trace_bits, MAP_SIZE, HASH_CONST));
+
+//  q->exec_cksum = ck1;
+
+  if (!WIFSTOPPED(status)) child_pid = 0;
+
+  if (child_timed_out) return FAULT_TMOUT;
+
+  if (WIFEXITED(status))
+  {
+    DEBUGF("child exited normal exit status= %d\n", WEXITSTATUS(status));
+    return FAULT_NONE;
+  }
+  else if (WIFSIGNALED(status)){
+    DEBUGF("child exited abnormal signal number= %d \n", WTERMSIG(status));
+    return FAULT_CRASH;
+  }
+  //else if (WIFSTOPPED(status)){
+  //   printf("child stoped signal number=%d\n", WSTOPSIG(status));
+  //   return FAULT_ERROR;
+  //}
+  else if (tb4 == EXEC_FAIL_SIG){
+    return FAULT_ERROR;
+  }
+
+  //if (devcloud_gpu_enable) {
+  //  devcloud_gpu_exec(app,argv);
+  //}
+
+  //if (devcloud_fpga_enable) {
+  //  devcloud_fpga_exec(app,argv);
+  //}
+
+       
+}
+/* Set up the -D backends. The target must be built once per backend, as
+   <app>.fpga_emu, <app>.fpga, <app>.gpu or <app>.cpu; the first backend
+   listed is the reference the others are compared against. */
+
+static void setup_backends(char* app) {
+
+  static const char* known[] = {"fpga_emu", "fpga", "gpu", "cpu"};
+  std::string list(backend_list);
+  size_t pos = 0;
+
+  while (pos <= list.size()) {
+
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) end = list.size();
+
+    std::string name = list.substr(pos, end - pos);
+    pos = end + 1;
+    if (name.empty()) continue;
+
+    bool ok = false;
+    for (auto k : known) if (name == k) ok = true;
+    if (!ok) FATAL("Unknown backend '%s' (use fpga_emu, fpga, gpu or cpu)", name.c_str());
+
+    struct local_backend b;
+    b.name = name;
+    b.bin = std::string(app) + "." + name;
+    b.dir = std::string(out_dir) + ".backends/" + name + "/";
+    b.pid = 0;
+    b.exec_ms = 0;
+
+    if (access(b.bin.c_str(), X_OK)) PFATAL("Backend binary '%s' not found", b.bin.c_str());
+
+    /* The backends chdir into their own directory. */
+
+    char abs_bin[PATH_MAX];
+    if (!realpath(b.bin.c_str(), abs_bin)) PFATAL("Unable to resolve '%s'", b.bin.c_str());
+    b.bin = abs_bin;
+
+    mkdir(out_dir, 0700);
+    mkdir((std::string(out_dir) + ".backends").c_str(), 0700);
+    if (mkdir(b.dir.c_str(), 0700) && errno != EEXIST)
+      PFATAL("Unable to create '%s'", b.dir.c_str());
+
+    backends.push_back(b);
+
+  }
+
+  if (backends.size() < 2) FATAL("-D needs at least two backends to compare");
+
+  if (input_path[0] != '/') {
+    char abs_input[PATH_MAX];
+    if (!realpath(input_path.c_str(), abs_input))
+      PFATAL("Unable to resolve '%s'", input_path.c_str());
+    input_path = abs_input;
+  }
+
+  OKF("Comparing %u local backends against %s.", (u32)backends.size(),
+      backends[0].name.c_str());
+
+}
+
+/* Run one test case on all -D backends at once and wait for all of them,
+   so an input costs the slowest backend rather than the sum. They all
+   write to the same coverage map; only the reference gets the metrics
+   record, the others leave theirs in their working directory. */
+
+static int run_backends(const std::string &content) {
+
+  int fault = FAULT_NONE;
+  u32 running = 0;
+  u64 start = get_cur_time();
+
+  memset(trace_bits, 0, MAP_SIZE);
+  memset(metrics, 0, sizeof(*metrics));
+  metrics->knob = cur_case.dev_arm + 1;
+  metrics->variant = cur_case.var_arm + 1;
+  metrics->seed = cur_case.seed;
+  write_test_case(content);
+
+  for (size_t i = 0; i < backends.size(); i++) {
+
+    struct local_backend &b = backends[i];
+
+    /* No stale output may stand in for this run's. */
+
+    unlink((b.dir + BACKEND_OUTPUT).c_str());
+    unlink((b.dir + METRICS_FILE).c_str());
+
+    b.pid = fork();
+    if (b.pid < 0) PFATAL("fork() failed");
+
+    if (!b.pid) {
+
+      char* argv[] = {(char*)b.bin.c_str(), (char*)input_path.c_str(), NULL};
+
+      setpgid(0, 0);
+      if (chdir(b.dir.c_str())) exit(1);
+
+      if (i) {
+        unsetenv(METRICS_ENV_VAR);
+        setenv(KNOB_ENV_VAR, std::to_string(cur_case.dev_arm + 1).c_str(), 1);
+        setenv(VARIANT_ENV_VAR, std::to_string(cur_case.var_arm + 1).c_str(), 1);
+        setenv(SEED_ENV_VAR, std::to_string(cur_case.seed).c_str(), 1);
+      }
+
+      execv(argv[0], argv);
+      *(u32*)trace_bits = EXEC_FAIL_SIG;
+      exit(0);
+
+    }
+
+    running++;
+
+  }
+
+  /* Collect them in the order they finish. A timeout takes down all the
+     ones still running. */
+
+  arm_timeout(exec_tmout);
+
+  while (running) {
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+
+    if (pid < 0) {
+      if (errno == EINTR) continue;
+      PFATAL("waitpid() failed");
+    }
+
+    for (auto &b : backends) {
+
+      if (b.pid != pid) continue;
+
+      b.pid = 0;
+      b.exec_ms = get_cur_time() - start;
+      running--;
+
+      if (WIFSIGNALED(status)) {
+        DEBUGF("backend %s crashed with signal %d after %llu ms\n",
+               b.name.c_str(), WTERMSIG(status), b.exec_ms);
+        fault = FAULT_CRASH;
+      } else {
+        DEBUGF("backend %s finished after %llu ms\n", b.name.c_str(), b.exec_ms);
+      }
+
+    }
+
+  }
+
+  disarm_timeout();
+
+  if (child_timed_out) return FAULT_TMOUT;
+  if (fault == FAULT_NONE && *(u32*)trace_bits == EXEC_FAIL_SIG) fault = FAULT_ERROR;
+
+  return fault;
+
+}
+
+int check_execution_divergent(const std::string &dir);
+
+bool larger(std::string current, int max){
+  if(max > atoi(current.c_str())){
+    return false;
+  }
+  else{
+    max = atoi(current.c_str());
+    return true;
+  }
+}
+
+bool smaller(std::string current, int min){
+  if(min < atoi(current.c_str())){
+    return false;
+  }
+  else{
+    min = atoi(current.c_str());
+    return true;
+  }
+}
+
+/* Get the metrics record of the last execution: from shm for local runs,
+   from the job directory for devcloud jobs. Returns false if the target
+   did not write one, in which case we fall back to the exec_*info.txt
+   reports. */
+
+static bool load_metrics(const std::string &dir, struct hfuzz_metrics* m) {
+
+  if (dir.empty()) {
+    memcpy(m, metrics, sizeof(*m));
+  } else {
+    FILE* f = fopen((dir + METRICS_FILE).c_str(), "rb");
+    if (!f) return false;
+    if (fread(m, sizeof(*m), 1, f) != 1) m->magic = 0;
+    fclose(f);
+  }
+
+  return m->magic == METRICS_MAGIC;
+
+}
+
+/* Harnesses that don't write a metrics record: read the exec_*info.txt
+   reports of the backends we run on into one. */
+
+static void load_legacy_metrics(const std::string &dir, struct hfuzz_metrics* m) {
+
+  memset(m, 0, sizeof(*m));
+  m->magic = METRICS_MAGIC;
+
+  if (devcloud_gpu_enable) {
+    std::ifstream inFile;
+    inFile.open(dir + "exec_info.txt");
+    if (!inFile.is_open()){
+            std::cout<<"can't open exec_info file\n";
+    }
+    if (inFile >> m->gflops) m->flags |= M_GFLOPS;
+    inFile.close();
+  }
+
+  if (devcloud_fpga_hd_enable or devcloud_fpga_enable){
+    std::ifstream inFile;
+    inFile.open(dir + "exec_fpga_info.txt");
+    if (!inFile.is_open()){
+            std::cout<<"can't open exec_info file\n";
+    }
+    if (inFile >> m->exec_time) m->flags |= M_EXEC_TIME;
+    if (inFile >> m->dsps) m->flags |= M_DSPS;
+    if (inFile >> m->fmax) m->flags |= M_FMAX;
+    inFile.close();
+  }
+
+}
+
+/* Log-scale bucket of a metric: one bucket per power of two, with the sign
+   kept apart. 128 is zero, buckets above are positive, below negative; the
+   ends of the range hold the non-finite values. */
+
+static u8 hw_bucket(double v) {
+
+  int e;
+
+  if (isnan(v)) return 254;
+  if (isinf(v)) return v > 0 ? 255 : 0;
+  if (v == 0) return 128;
+
+  frexp(fabs(v), &e);
+
+  if (e < -60) e = -60;
+  if (e > 60) e = 60;
+
+  return v > 0 ? 129 + 60 + e : 127 - 60 - e;
+
+}
+
+/* The time a run competes on: the device's kernel time if the harness
+   profiled its kernels, the execution time it measured otherwise. Returns
+   false if it reported neither. */
+
+static bool hw_perf(const struct hfuzz_metrics* m, double* t) {
+
+  if (m->flags & M_KERNEL_TIME) *t = m->kernel_time;
+  else if (m->flags & M_EXEC_TIME) *t = m->exec_time;
+  else return false;
+
+  return true;
+
+}
+
+/* Bucket of every metric the record holds; -1 for the ones it doesn't. */
+
+static void hw_features(const struct hfuzz_metrics* m, s32 feat[HW_FEATURES]) {
+
+  double t;
+
+  for (u32 i = 0; i < HW_FEATURES; i++) feat[i] = -1;
+
+  if (hw_perf(m, &t))         feat[0] = hw_bucket(t);
+  if (m->flags & M_DSPS)      feat[1] = hw_bucket(m->dsps);
+  if (m->flags & M_FMAX)      feat[2] = hw_bucket(m->fmax);
+  if (m->flags & M_GFLOPS)    feat[3] = hw_bucket(m->gflops);
+
+  for (u32 i = 0; i < METRICS_PROBES; i++) {
+    if (!(m->probe_mask & (1 << i))) continue;
+    feat[4 + 2 * i] = hw_bucket(m->probe_min[i]);
+    feat[5 + 2 * i] = hw_bucket(m->probe_max[i]);
+  }
+
+}
+
+/* Record the buckets of this execution. Returns 1 if any of them is new;
+   a new time bucket alone goes to hw_claim instead. */
+
+static int has_new_hw_buckets(const s32 feat[HW_FEATURES]) {
+
+  int ret_val = 0;
+
+  for (u32 i = 0; i < HW_FEATURES; i++) {
+
+    if (feat[i] < 0 || hw_virgin[i][feat[i]]) continue;
+
+    hw_virgin[i][feat[i]] = 1;
+    hw_buckets_hit++;
+    DEBUGF("new hardware bucket %d for metric %u\n", feat[i], i);
+    ret_val = 1;
+
+    if (i) hw_claim.other = 1;
+    else hw_claim.time_bucket = feat[i];
+
+  }
+
+  return ret_val;
+
+}
+
+/* Compete for the cell of this execution. Fitness is the time (hw_perf()):
+   within a cell (same buckets for everything else) we are after the
+   slowest inputs. Returns 1 if we took over the cell, on the strength of
+   one run; calibrate_case() then decides whether that stands. */
+
+static int update_hw_elites(const struct hfuzz_metrics* m, const s32 feat[HW_FEATURES]) {
+
+  double t;
+  s32 other[HW_FEATURES] = {0};
+
+  if (!hw_perf(m, &t)) return 0;
+
+  /* The cell is every bucket but the time's. hash32() takes whole u64
+     words, so those go into a buffer of a multiple of 8 bytes; hashed in
+     place, the last probe would not count. */
+
+  memcpy(other, feat + 1, sizeof(s32) * (HW_FEATURES - 1));
+
+  u32 cell = hash32(other, sizeof(other), HASH_CONST);
+  auto e = hw_elites.find(cell);
+
+  hw_claim.cell_id = cell;
+  hw_claim.perf = t;
+
+  /* A cell nobody had is a new combination of the other metrics, not a
+     claim about the time. */
+
+  if (e == hw_elites.end()) {
+    hw_elites[cell] = {t, 0, 1};
+    hw_claim.cell = 1;
+    hw_claim.other = 1;
+    return 1;
+  }
+
+  if (t <= e->second.mean * HW_ELITE_MARGIN) return 0;
+
+  DEBUGF("new elite for hardware cell %08x: %lf -> %lf\n", cell,
+         e->second.mean, t);
+  hw_claim.cell = 1;
+  hw_claim.had_prev = 1;
+  hw_claim.prev = e->second;
+  e->second = {t, 0, 1};
+  return 1;
+
+}
+
+/* Hash of all metrics in the record, each rounded to 4 significant bits so
+   that timing noise does not make every run look different. Much finer
+   than the buckets: it tells clones apart, not behaviors. */
+
+static inline u64 hw_metric_key(double v) {
+
+  int e;
+  double m = frexp(v, &e);
+
+  if (!isfinite(v)) return 0xffff;
+  return (u64)((e + 1024) * 32 + (int)(m * 16) + 16) & 0xffff;
+
+}
+
+static u32 hw_metrics_key(const struct hfuzz_metrics* m) {
+
+  u64 keys[4 + 2 * METRICS_PROBES] = { 0 };
+  double t;
+
+  if (hw_perf(m, &t))         keys[0] = hw_metric_key(t);
+  if (m->flags & M_DSPS)      keys[1] = hw_metric_key(m->dsps);
+  if (m->flags & M_FMAX)      keys[2] = hw_metric_key(m->fmax);
+  if (m->flags & M_GFLOPS)    keys[3] = hw_metric_key(m->gflops);
+
+  for (u32 i = 0; i < METRICS_PROBES; i++) {
+    if (!(m->probe_mask & (1 << i))) continue;
+    keys[4 + 2 * i] = hw_metric_key(m->probe_min[i]);
+    keys[5 + 2 * i] = hw_metric_key(m->probe_max[i]);
+  }
+
+  return hash32(keys, sizeof(keys), HASH_CONST);
+
+}
+
+/* Read the hardware characteristics the target left in dir (the current
+   directory for local runs, the job directory for devcloud runs). */
+
+int check_new_hardware(const std::string &dir){
+  int ret_val;
+  struct hfuzz_metrics m;
+  s32 feat[HW_FEATURES];
+
+  if(hardware_enabled){
+    std::ifstream ifs("hls_report/solution1/*.rpt");
+    std::string content( (std::istreambuf_iterator<char>(ifs) ),
+                       (std::istreambuf_iterator<char>()    ) );
+    if(larger(content, current_max)){
+      ret_val = 1;
+    }else ret_val = 0;
+  }else{
+    ret_val = 0;
+  }
+
+  u64 start_us = get_cur_time_us();
+
+  if (cache_replay) m = last_metrics;
+  else if (!load_metrics(dir, &m)) load_legacy_metrics(dir, &m);
+
+  telem_record(STAGE_METRICS, get_cur_time_us() - start_us);
+
+  last_metrics = m;
+  cur_hw_key = hw_metrics_key(&m);
+
+  if (m.flags & M_GFLOPS) DEBUGF("gflops:%lf\n", m.gflops);
+  if (m.flags & M_EXEC_TIME) DEBUGF("execution time:%lf\n", m.exec_time);
+  if (m.flags & M_KERNEL_TIME) DEBUGF("kernel time:%lf\n", m.kernel_time);
+
+  hw_features(&m, feat);
+
+  memset(&hw_claim, 0, sizeof(hw_claim));
+  hw_claim.time_bucket = -1;
+  hw_claim.other = ret_val;
+
+  if (has_new_hw_buckets(feat)) ret_val = 1;
+  if (update_hw_elites(&m, feat)) ret_val = 1;
+
+  if (!cache_replay) last_divergent = check_execution_divergent(dir) == 1;
+  if (last_divergent) hw_claim.other = 1;
+  if (last_divergent) return 1;
+  return ret_val;
+}
+
+/* Differential comparison of the outputs of two backends. Outputs can be
+   hundreds of MB, so both files are mapped and walked value by value,
+   without building any copies; the walk stops at the first divergence.
+   Outputs are either text (whitespace-separated numbers; tokens that are
+   not numbers have to match exactly) or HFZB. */
+
+struct out_cursor {
+  const u8 *ptr, *end;                /* Unread part of the mapping       */
+  bool binary;                        /* HFZB rather than text            */
+  u32 run_left, run_type,             /* Current HFZB run                 */
+      runs_left;
+};
+
+struct out_value {
+  double num;                         /* The value, if a number           */
+  const u8* tok;                      /* Raw token, if not a number       */
+  u32 tok_len;
+};
+
+static void out_cursor_init(struct out_cursor* c, const u8* mem, size_t len) {
+
+  memset(c, 0, sizeof(*c));
+  c->ptr = mem;
+  c->end = mem + len;
+
+  if (len >= 8 && !memcmp(mem, HFZB_MAGIC, 4)) {
+    c->binary = 1;
+    memcpy(&c->runs_left, mem + 4, 4);
+    c->ptr += 8;
+  }
+
+}
+
+/* Fetch the next value. Returns false at the end of the output (or when an
+   HFZB output is truncated). */
+
+static bool out_cursor_next(struct out_cursor* c, struct out_value* v) {
+
+  v->tok = NULL;
+
+  if (c->binary) {
+
+    while (!c->run_left) {
+      if (!c->runs_left || c->end - c->ptr < 8) return false;
+      memcpy(&c->run_type, c->ptr, 4);
+      memcpy(&c->run_left, c->ptr + 4, 4);
+      c->ptr += 8;
+      c->runs_left--;
+    }
+
+    if (c->run_type == T_I64) {
+      s64 i;
+      if (c->end - c->ptr < 8) return false;
+      memcpy(&i, c->ptr, 8);
+      v->num = i;
+      c->ptr += 8;
+    } else {
+      float f;
+      if (c->end - c->ptr < 4) return false;
+      memcpy(&f, c->ptr, 4);
+      v->num = f;
+      c->ptr += 4;
+    }
+
+    c->run_left--;
+    return true;
+
+  }
+
+  while (c->ptr < c->end && isspace(*c->ptr)) c->ptr++;
+  if (c->ptr == c->end) return false;
+
+  const u8* tok = c->ptr;
+  while (c->ptr < c->end && !isspace(*c->ptr)) c->ptr++;
+
+  /* from_chars does not take a leading '+'. */
+
+  const char* first = (const char*)tok + (*tok == '+');
+  auto res = std::from_chars(first, (const char*)c->ptr, v->num);
+
+  if (res.ec != std::errc() || res.ptr != (const char*)c->ptr) {
+
+    /* inf / nan are spelled in many ways; anything else is a word. */
+
+    char buf[16];
+    u32 len = c->ptr - tok;
+
+    if (len < sizeof(buf)) {
+      memcpy(buf, tok, len);
+      buf[len] = 0;
+      char* end;
+      v->num = strtod(buf, &end);
+      if (end == buf + len) return true;
+    }
+
+    v->tok = tok;
+    v->tok_len = len;
+
+  }
+
+  return true;
+
+}
+
+/* Distance in units in the last place, in single precision: the kernels
+   compute in float, so that is what a ULP tolerance should mean. */
+
+static u64 ulp_distance(double a, double b) {
+
+  float fa = a, fb = b;
+  s32 ia, ib;
+
+  memcpy(&ia, &fa, 4);
+  memcpy(&ib, &fb, 4);
+
+  /* Map the sign-magnitude floats onto a monotonic integer line. */
+
+  if (ia < 0) ia = INT_MIN - ia;
+  if (ib < 0) ib = INT_MIN - ib;
+
+  return ia > ib ? (u64)((s64)ia - ib) : (u64)((s64)ib - ia);
+
+}
+
+static bool values_match(const struct out_value* a, const struct out_value* b) {
+
+  if (a->tok || b->tok)
+    return a->tok && b->tok && a->tok_len == b->tok_len &&
+           !memcmp(a->tok, b->tok, a->tok_len);
+
+  if (a->num == b->num) return true;
+  if (isnan(a->num) && isnan(b->num)) return true;
+  if (isnan(a->num) || isnan(b->num) || isinf(a->num) || isinf(b->num))
+    return false;
+
+  if (ulp_distance(a->num, b->num) <= max_ulps) return true;
+
+  return max_rel_err > 0 && fabs(a->num - b->num) <=
+         max_rel_err * fmax(fabs(a->num), fabs(b->num));
+
+}
+
+static const u8* map_output(const std::string &fn, size_t* len) {
+
+  struct stat st;
+  s32 fd = open(fn.c_str(), O_RDONLY);
+
+  if (fd < 0) return NULL;
+
+  if (fstat(fd, &st) || !st.st_size) {
+    close(fd);
+    *len = 0;
+    return (const u8*)"";
+  }
+
+  void* mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mem == MAP_FAILED) return NULL;
+
+#ifdef MADV_SEQUENTIAL
+  madvise(mem, st.st_size, MADV_SEQUENTIAL);
+#endif /* MADV_SEQUENTIAL */
+
+  *len = st.st_size;
+  return (const u8*)mem;
+
+}
+
+/* Compare two outputs. Returns true if they agree, or if there is nothing
+   to compare (a backend did not produce its output). */
+
+bool verify_result(std::string output, std::string res){
+
+  size_t len_a, len_b;
+  const u8* mem_a = map_output(output, &len_a);
+  const u8* mem_b = map_output(res, &len_b);
+  bool ret = true;
+
+  if (!mem_a || !mem_b) {
+    if (mem_a && len_a) munmap((void*)mem_a, len_a);
+    if (mem_b && len_b) munmap((void*)mem_b, len_b);
+    return true;
+  }
+
+  DEBUGF("%s", "check results across different platform...");
+
+  struct out_cursor ca, cb;
+  struct out_value va, vb;
+  u64 idx = 0;
+
+  out_cursor_init(&ca, mem_a, len_a);
+  out_cursor_init(&cb, mem_b, len_b);
+
+  while (1) {
+
+    bool more_a = out_cursor_next(&ca, &va),
+         more_b = out_cursor_next(&cb, &vb);
+
+    if (!more_a && !more_b) break;
+
+    if (more_a != more_b) {
+      DEBUGF("divergent results across different platform: %s ends at "
+             "value %llu\n", more_a ? res.c_str() : output.c_str(), idx);
+      ret = false;
+      break;
+    }
+
+    if (!values_match(&va, &vb)) {
+      if (va.tok || vb.tok)
+        DEBUGF("divergent results across different platform at value %llu: "
+               "'%.*s' vs '%.*s'\n", idx, va.tok ? va.tok_len : 3,
+               va.tok ? (char*)va.tok : "num", vb.tok ? vb.tok_len : 3,
+               vb.tok ? (char*)vb.tok : "num");
+      else
+        DEBUGF("divergent results across different platform at value %llu: "
+               "%.9g vs %.9g (abs %g, %llu ulps)\n", idx, va.num, vb.num,
+               fabs(va.num - vb.num), ulp_distance(va.num, vb.num));
+      ret = false;
+      break;
+    }
+
+    idx++;
+
+  }
+
+  if (ret) DEBUGF("%llu values agree\n", idx);
+
+  if (len_a) munmap((void*)mem_a, len_a);
+  if (len_b) munmap((void*)mem_b, len_b);
+
+  return ret;
+
+}
+
+int check_execution_divergent(const std::string &dir){
+
+  /* -D: every backend against the reference. */
+
+  if (!backends.empty()) {
+    for (size_t i = 1; i < backends.size(); i++)
+      if (!verify_result(backends[0].dir + BACKEND_OUTPUT,
+                         backends[i].dir + BACKEND_OUTPUT)) {
+        DEBUGF("%s diverges from %s\n", backends[i].name.c_str(),
+               backends[0].name.c_str());
+        return 1;
+      }
+    return 0;
+  }
+
+  if (!verify_result(dir + "gpu.txt", dir + "fpga_simulation.txt")) return 1;
+  //if (!verify_result("gpu.txt","fpga.txt")) return 1;
+  return 0;
+}
+
+int check_performance_divergent(){
+    int ret_val;
+    if (hardware_enabled){
+        std::ifstream ifs("hls_report/solution1/*.rpt");
+        
+    }
+    return ret_val;
+}
+
+// change the probability based on update rule
+/* Coverage bookkeeping, as in AFL: hit counts are classified into buckets
+   (1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+), and a virgin map remembers
+   which buckets of which tuples we have seen. This runs after every
+   execution, so both passes work on 64-bit words and skip runs of zero
+   bytes, 32 at a time with AVX2. */
+
+static u8 count_class_lookup8[256];
+
+/* C++ has no range designators, so the tables are filled at startup. */
+
+static void init_count_class16(void) {
+
+  u32 b1, b2;
+
+  for (b1 = 0; b1 < 256; b1++)
+    count_class_lookup8[b1] = b1 < 4 ? (b1 == 3 ? 4 : b1) :
+                              b1 < 8 ? 8 : b1 < 16 ? 16 : b1 < 32 ? 32 :
+                              b1 < 128 ? 64 : 128;
+
+  for (b1 = 0; b1 < 256; b1++) 
+    for (b2 = 0; b2 < 256; b2++)
+      count_class_lookup16[(b1 << 8) + b2] = 
+        (count_class_lookup8[b1] << 8) |
+        count_class_lookup8[b2];
+
+}
+
+#ifdef __AVX2__
+
+static inline u8 zero_block32(const void* ptr) {
+
+  __m256i v = _mm256_loadu_si256((const __m256i*)ptr);
+  return _mm256_testz_si256(v, v);
+
+}
+
+#endif /* __AVX2__ */
+
+/* Replace raw hit counts with their buckets. */
+
+static inline void classify_counts(u64* mem) {
+
+  u32 i = MAP_SIZE >> 3;
+
+  while (i) {
+
+#ifdef __AVX2__
+
+    if (!(i & 3) && zero_block32(mem)) {
+      mem += 4;
+      i   -= 4;
+      continue;
+    }
+
+#endif /* __AVX2__ */
+
+    /* Optimize for sparse bitmaps. */
+
+    if (unlikely(*mem)) {
+
+      u16* mem16 = (u16*)mem;
+
+      mem16[0] = count_class_lookup16[mem16[0]];
+      mem16[1] = count_class_lookup16[mem16[1]];
+      mem16[2] = count_class_lookup16[mem16[2]];
+      mem16[3] = count_class_lookup16[mem16[3]];
+
+    }
+
+    mem++;
+    i--;
+
+  }
+
+}
+
+/* Check if the current (classified) execution path brings anything new,
+   and fold it into the virgin map. Returns 1 if the only change is a new
+   hit-count bucket for some tuple, 2 if there are new tuples, 0 if
+   nothing is new. */
+
+static inline u8 has_new_bits(u8* virgin_map) {
+
+  u64* current = (u64*)trace_bits;
+  u64* virgin  = (u64*)virgin_map;
+
+  u32  i = (MAP_SIZE >> 3);
+  u8   ret = 0;
+
+  while (i) {
+
+#ifdef __AVX2__
+
+    if (!(i & 3) && zero_block32(current)) {
+      current += 4;
+      virgin  += 4;
+      i       -= 4;
+      continue;
+    }
+
+#endif /* __AVX2__ */
+
+    if (unlikely(*current) && unlikely(*current & *virgin)) {
+
+      if (likely(ret < 2)) {
+
+        u8* cur = (u8*)current;
+        u8* vir = (u8*)virgin;
+
+        /* A byte going from 0xff (never seen) to anything else is a new
+           tuple; otherwise it is just a new hit-count bucket. */
+
+        for (u32 b = 0; b < 8; b++)
+          if (cur[b] && vir[b] == 0xff) ret = 2;
+
+        if (!ret) ret = 1;
+
+      }
+
+      *virgin &= ~*current;
+
+    }
+
+    current++;
+    virgin++;
+    i--;
+
+  }
+
+  return ret;
+
+}
+
+/*save the input if a new edge is covered, or an edge is hit a new number of
+times, or a hardware divergence character is maximized.
+return 0 if not interested, return 1 if new coverage, return 2 if new hardware character,
+return 3 if both; dir is where the target left its hardware reports
+*/
+
+int save_if_interest(const std::string &dir = ""){
+  int ret_val = 0;
+  int new_coverage = 0;
+  int new_hardware = 0;
+  u64 start_us = get_cur_time_us();
+
+  classify_counts((u64*)trace_bits);
+  new_coverage = has_new_bits(virgin_bits) != 0;
+
+  if (new_coverage) {
+    u32 cov = 0;
+    for (u32 i = 0; i < MAP_SIZE; i++) cov += virgin_bits[i] != 0xff;
+    telem_cov.store(cov, std::memory_order_relaxed);
+  }
+
+  telem_record(STAGE_MERGE, get_cur_time_us() - start_us);
+
+  new_hardware = check_new_hardware(dir);
+  
+  if(new_coverage && new_hardware){
+    return NEW_BOTH;
+  }else if(new_coverage && !new_hardware){
+    return NEW_COVERAGE;
+  }else if(!new_coverage && new_hardware){
+    return NEW_HARDWARE;
+  }
+
+  return NOT_INTEREST;
+}
+
+/* Behavior of the last execution: the classified trace plus its hardware
+   metrics (see hw_metrics_key()). */
+
+static u64 behavior_key() {
+
+  return (u64)hash32(trace_bits, MAP_SIZE, HASH_CONST) << 32 | cur_hw_key;
+
+}
+
+/* Stable 64-bit hash (FNV-1a) for everything that goes to disk. */
+
+static u64 fnv64(const void* mem, size_t len) {
+
+  const u8* ptr = (const u8*)mem;
+  u64 h = 0xcbf29ce484222325ULL;
+
+  while (len--) {
+    h ^= *ptr++;
+    h *= 0x100000001b3ULL;
+  }
+
+  return h;
+
+}
+
+static bool canonical_keys;           /* -K: key test cases by value      */
+
+/* What identifies a test case for is_dup_input() and the result cache:
+   its bytes, or with -K its parsed values, so that "1.0" and "1.00 " (or
+   the same values as text and as HFZB) count as the same test case. */
+
+static u64 input_key(const std::string &content) {
+
+  if (canonical_keys) {
+
+    std::vector<typed_value> vals;
+    parse_typed(content, vals);
+
+    if (!vals.empty()) {
+      std::string canon = emit_typed(vals, 1);
+      return fnv64(canon.data(), canon.size());
+    }
+
+  }
+
+  return fnv64(content.data(), content.size());
+
+}
+
+/* input_key() of the test case about to run, with its kernel variant
+   mixed in under -V: the same input under another configuration is a
+   different test case. */
+
+static u64 case_key(const std::string &content) {
+
+  u64 key = input_key(content);
+
+  if (cur_case.var_arm >= 0)
+    key ^= (u64)(cur_case.var_arm + 1) * 0x9e3779b97f4a7c15ULL;
+
+  return key;
+
+}
+
+/* Returns true if exactly this test case has been run before. */
+
+static bool is_dup_input(const std::string &content) {
+
+  if (seen_inputs.insert(case_key(content)).second) return false;
+
+  skipped_inputs++;
+  return true;
+
+}
+
+/* Result cache. Mutators often come up with a test case that an earlier
+   campaign in the same output dir already ran, and each one used to cost
+   a full run (or a round of devcloud jobs). Every evaluated test case
+   leaves its result in out_dir/results.cache:
+
+     "HFZC"  u32 version  u64 config
+     n x { struct cache_rec, metrics (up to the series), edge_cnt x u32 }
+
+   A record keeps all the evaluation looks at: the raw trace as
+   index << 8 | count pairs, the hardware metrics, the divergence verdict,
+   plus a digest of the reference output. A hit puts those back and goes
+   through the same bookkeeping as a run. config is a hash of whatever
+   else the results depend on (target binaries and scripts, devcloud or
+   local, output tolerances, -K); a cache made under another config is
+   dropped. Like is_dup_input(), the cache takes a test case to be a
+   function of its contents: the knob and seed handed to the harness are
+   not part of the key (the -V kernel variant is). */
+
+#define CACHE_FILE     "results.cache"
+#define CACHE_MAGIC    0x435a4648     /* "HFZC"                           */
+#define CACHE_VERSION  2
+#define CACHE_METRICS  offsetof(struct hfuzz_metrics, step_time)
+
+struct cache_rec {
+  u64 key;                            /* case_key() of the test case      */
+  u64 out_digest;                     /* Reference output, 0 if none      */
+  u64 exec_us;                        /* Execution time of the run        */
+  u32 trace_cksum;                    /* hash32() of the raw trace        */
+  u32 edge_cnt;                       /* Non-zero bytes in the trace      */
+  u8  fault;                          /* FAULT_NONE or FAULT_CRASH        */
+  u8  divergent;                      /* Backends disagreed               */
+  u8  reserved[6];
+};
+
+static s32 cache_fd = -1;             /* results.cache                    */
+static u64 cache_end;                 /* ... where the next record goes   */
+static std::unordered_map<u64, u64> cache_index;  /* Key -> file offset   */
+static u64 cache_hits;                /* Runs answered from the cache     */
+static std::vector<u32> cache_edges;  /* Raw trace of the last run        */
+static u32 cache_cksum;               /* ... its checksum                 */
+
+static inline bool devcloud_jobs();
+
+static u64 cache_config() {
+
+  std::string desc = std::to_string(devcloud_fpga_enable) +
+                     std::to_string(devcloud_fpga_hd_enable) +
+                     std::to_string(devcloud_gpu_enable);
+  std::vector<std::string> files;
+
+  if (!backends.empty()) {
+    for (auto &b : backends) files.push_back(b.bin);
+  } else {
+    files.push_back(target_path);
+    if (devcloud_jobs()) {
+      files.push_back(std::string(target_path) + "-fpga.sh");
+      files.push_back(std::string(target_path) + "-gpu.sh");
+    }
+  }
+
+  for (auto &fn : files) {
+    struct stat st;
+    desc += " " + fn;
+    if (!stat(fn.c_str(), &st))
+      desc += ":" + std::to_string(st.st_size) + ":" + std::to_string(st.st_mtime);
+  }
+
+  desc += " " + std::to_string(max_ulps) + " " + std::to_string(max_rel_err) +
+          (canonical_keys ? " K" : "");
+
+  return fnv64(desc.data(), desc.size());
+
+}
+
+/* Load the index of the results of earlier runs, or start a new cache. */
+
+static void setup_result_cache() {
+
+  std::string fn = std::string(out_dir) + CACHE_FILE;
+  u32 hdr[2];
+  u64 config = cache_config(), old_config;
+  struct cache_rec rec;
+  struct stat st;
+
+  cache_fd = open(fn.c_str(), O_RDWR | O_CREAT, 0600);
+  if (cache_fd < 0) PFATAL("Unable to open '%s'", fn.c_str());
+
+  if (read(cache_fd, hdr, sizeof(hdr)) != sizeof(hdr) ||
+      read(cache_fd, &old_config, 8) != 8 || hdr[0] != CACHE_MAGIC ||
+      hdr[1] != CACHE_VERSION || old_config != config) {
+
+    hdr[0] = CACHE_MAGIC;
+    hdr[1] = CACHE_VERSION;
+
+    if (ftruncate(cache_fd, 0) || pwrite(cache_fd, hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+        pwrite(cache_fd, &config, 8, sizeof(hdr)) != 8)
+      PFATAL("Short write to '%s'", fn.c_str());
+
+    cache_end = sizeof(hdr) + 8;
+    return;
+
+  }
+
+  if (fstat(cache_fd, &st)) PFATAL("Unable to stat '%s'", fn.c_str());
+
+  cache_end = sizeof(hdr) + 8;
+
+  while (pread(cache_fd, &rec, sizeof(rec), cache_end) == sizeof(rec)) {
+
+    u64 size = sizeof(rec) + CACHE_METRICS + (u64)rec.edge_cnt * 4;
+
+    if (rec.edge_cnt > MAP_SIZE || cache_end + size > (u64)st.st_size) break;
+
+    cache_index[rec.key] = cache_end;
+    cache_end += size;
+
+  }
+
+  /* Drop a record cut short by a crash. */
+
+  if (ftruncate(cache_fd, cache_end)) PFATAL("Unable to truncate '%s'", fn.c_str());
+
+  OKF("Result cache: %u results of earlier runs.", (u32)cache_index.size());
+
+}
+
+/* Keep the raw trace of a run, before classify_counts() turns it into
+   buckets. */
+
+static void cache_snapshot() {
+
+  u64* words = (u64*)trace_bits;
+
+  cache_edges.clear();
+  cache_cksum = hash32(trace_bits, MAP_SIZE, HASH_CONST);
+
+  for (u32 w = 0; w < MAP_SIZE / 8; w++) {
+
+    if (!words[w]) continue;
+
+    for (u32 i = w * 8; i < w * 8 + 8; i++)
+      if (trace_bits[i]) cache_edges.push_back(i << 8 | trace_bits[i]);
+
+  }
+
+}
+
+static u64 output_digest(const std::string &dir) {
+
+  std::string fn = backends.empty() ? dir + "gpu.txt"
+                                    : backends[0].dir + BACKEND_OUTPUT;
+  size_t len;
+  const u8* mem = map_output(fn, &len);
+
+  if (!mem) return 0;
+
+  u64 h = fnv64(mem, len);
+  if (len) munmap((void*)mem, len);
+
+  return h;
+
+}
+
+/* Append the result of the last evaluation (see cache_snapshot() and
+   check_new_hardware()). Failed execs are not worth remembering, and
+   whether a run times out depends on the timeout of the campaign. */
+
+static void cache_store(const std::string &content, u8 fault,
+                        const std::string &dir) {
+
+  static struct hfuzz_metrics no_metrics;
+  struct cache_rec rec;
+
+  if (cache_fd < 0 || fault == FAULT_ERROR || fault == FAULT_TMOUT) return;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.key = case_key(content);
+  rec.out_digest = output_digest(dir);
+  rec.exec_us = cur_exec_us;
+  rec.trace_cksum = cache_cksum;
+  rec.edge_cnt = cache_edges.size();
+  rec.fault = fault;
+  rec.divergent = !fault && last_divergent;
+
+  std::string buf((char*)&rec, sizeof(rec));
+  buf.append((char*)(fault ? &no_metrics : &last_metrics), CACHE_METRICS);
+  buf.append((char*)cache_edges.data(), cache_edges.size() * 4);
+
+  if (pwrite(cache_fd, buf.data(), buf.size(), cache_end) != (ssize_t)buf.size()) {
+    WARNF("Short write to the result cache");
+    return;
+  }
+
+  cache_index[rec.key] = cache_end;
+  cache_end += buf.size();
+
+}
+
+/* Look a test case up. On a hit, trace_bits, last_metrics and
+   last_divergent are what its run left behind. */
+
+static bool cache_lookup(const std::string &content, struct cache_rec* rec) {
+
+  u64 key = case_key(content);
+  auto e = cache_index.find(key);
+
+  if (e == cache_index.end()) return false;
+
+  std::vector<u32> edges;
+  u64 off = e->second;
+
+  memset(&last_metrics, 0, sizeof(last_metrics));
+
+  if (pread(cache_fd, rec, sizeof(*rec), off) != sizeof(*rec) || rec->key != key)
+    goto bad;
+
+  edges.resize(rec->edge_cnt);
+  off += sizeof(*rec);
+
+  if (pread(cache_fd, &last_metrics, CACHE_METRICS, off) != (ssize_t)CACHE_METRICS ||
+      pread(cache_fd, edges.data(), edges.size() * 4, off + CACHE_METRICS) !=
+      (ssize_t)(edges.size() * 4))
+    goto bad;
+
+  memset(trace_bits, 0, MAP_SIZE);
+  for (auto v : edges) trace_bits[(v >> 8) % MAP_SIZE] = v & 0xff;
+
+  if (hash32(trace_bits, MAP_SIZE, HASH_CONST) != rec->trace_cksum) goto bad;
+
+  last_divergent = rec->divergent;
+  cache_hits++;
+  return true;
+
+bad:
+
+  WARNF("Dropping a damaged result cache entry");
+  cache_index.erase(e);
+  return false;
+
+}
+
+/* Write a test case to disk. */
+
+static void save_test_case(const std::string &fname, const std::string &content) {
+
+  std::ofstream out(fname, std::ios::binary);
+  out << content;
+  out.close();
+
+  if (!out) WARNF("Unable to write '%s'", fname.c_str());
+
+}
+
+/* Packed corpus (-P). A file per test case means a create and a write in
+   out_dir for every find, and a directory walk whenever a queue is read
+   back; on NFS, with hundreds of thousands of executions, those are what
+   the campaign waits for. With -P the output dir gets two files instead:
+
+     corpus.dat   the contents of every test case kept, back to back
+     corpus.idx   "HFZI" u32 version, then one struct corpus_rec each
+
+   Both are append-only; a record is written after its contents, so a
+   torn tail is a record short, never a record pointing at garbage.
+   Reading either back is one mmap: load_queue() takes a packed corpus as
+   input dir, and sync_fuzzers() reads the index of a peer. -x writes the
+   test cases out as the files they would have been. */
+
+#define CORPUS_DATA    "corpus.dat"
+#define CORPUS_INDEX   "corpus.idx"
+#define CORPUS_MAGIC   0x495a4648     /* "HFZI"                           */
+#define CORPUS_VERSION 1
+
+enum {
+  /* 01 */ CORPUS_COV   = 1,          /* New coverage                     */
+  /* 02 */ CORPUS_HW    = 2,          /* New hardware behavior            */
+  /* 04 */ CORPUS_CRASH = 4,          /* Crash                            */
+  /* 08 */ CORPUS_HANG  = 8,          /* Hang                             */
+  /* 10 */ CORPUS_SYNC  = 16          /* Imported from a peer             */
+};
+
+struct corpus_rec {
+  u64 offset;                         /* Contents, in corpus.dat          */
+  u32 len;                            /* ... their length                 */
+  u32 flags;                          /* CORPUS_*                         */
+  u32 cksum;                          /* hash32() of the contents         */
+  u32 exec_cksum;                     /* Checksum of the trace, 0 if none */
+  u64 exec_us;                        /* Execution time (us), 0 if none   */
+  u64 behavior;                       /* behavior_key(), 0 if none        */
+  double perf;                        /* hw_perf() of the run, 0 if none  */
+  char name[64];                      /* File name, without the dir       */
+};
+
+static bool packed_corpus;            /* -P                               */
+static bool export_mode;              /* -x                               */
+static s32 corpus_data_fd = -1,       /* corpus.dat                       */
+           corpus_index_fd = -1;      /* corpus.idx                       */
+static u64 corpus_end;                /* ... where the next contents go   */
+
+/* Start the packed corpus, or go on with the first keep_data and
+   keep_index bytes of the one a resumed campaign left behind. */
+
+static void setup_corpus(u64 keep_data = 0, u64 keep_index = 0) {
+
+  std::string dir(out_dir);
+  u32 hdr[2] = {CORPUS_MAGIC, CORPUS_VERSION};
+  struct stat sd, si;
+
+  if (keep_index && !stat((dir + CORPUS_DATA).c_str(), &sd) &&
+      !stat((dir + CORPUS_INDEX).c_str(), &si) &&
+      (u64)sd.st_size >= keep_data && (u64)si.st_size >= keep_index) {
+
+    corpus_data_fd = open((dir + CORPUS_DATA).c_str(), O_WRONLY | O_APPEND);
+    corpus_index_fd = open((dir + CORPUS_INDEX).c_str(), O_WRONLY | O_APPEND);
+
+    if (corpus_data_fd < 0 || corpus_index_fd < 0 ||
+        ftruncate(corpus_data_fd, keep_data) ||
+        ftruncate(corpus_index_fd, keep_index))
+      PFATAL("Unable to continue the packed corpus in '%s'", out_dir);
+
+    corpus_end = keep_data;
+    return;
+
+  }
+
+  corpus_data_fd = open((dir + CORPUS_DATA).c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+  corpus_index_fd = open((dir + CORPUS_INDEX).c_str(),
+                         O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+
+  if (corpus_data_fd < 0 || corpus_index_fd < 0)
+    PFATAL("Unable to create the packed corpus in '%s'", out_dir);
+
+  if (write(corpus_index_fd, hdr, sizeof(hdr)) != sizeof(hdr))
+    PFATAL("Short write to '%s'", (dir + CORPUS_INDEX).c_str());
+
+  corpus_end = 0;
+
+}
+
+/* Keep a test case: as the file fname, or in the packed corpus. q is the
+   queue entry it became, if any. */
+
+static void store_test_case(const std::string &fname, const std::string &content,
+                            u32 flags, const struct queue_entry* q) {
+
+  struct corpus_rec rec;
+  double perf;
+
+  if (!packed_corpus) {
+    save_test_case(fname, content);
+    return;
+  }
+
+  std::string base = fname.substr(fname.rfind('/') + 1);
+
+  memset(&rec, 0, sizeof(rec));
+  rec.offset = corpus_end;
+  rec.len = content.size();
+  rec.flags = flags;
+  rec.cksum = hash32(content.data(), content.size(), HASH_CONST);
+  strncpy(rec.name, base.c_str(), sizeof(rec.name) - 1);
+
+  if (!base.compare(0, 5, "sync-")) rec.flags |= CORPUS_SYNC;
+
+  if (q) {
+    rec.exec_cksum = q->exec_cksum;
+    rec.exec_us = q->exec_us;
+    rec.behavior = q->behavior;
+    if (hw_perf(&last_metrics, &perf)) rec.perf = perf;
+  }
+
+  if (write(corpus_data_fd, content.data(), content.size()) !=
+      (ssize_t)content.size() ||
+      write(corpus_index_fd, &rec, sizeof(rec)) != sizeof(rec)) {
+    WARNF("Short write to the packed corpus");
+    return;
+  }
+
+  corpus_end += content.size();
+
+}
+
+/* A packed corpus, mapped. Records past the end of the data (a torn
+   write) are not counted. */
+
+struct corpus_map {
+  const u8* index;                    /* corpus.idx                       */
+  const struct corpus_rec* recs;      /* ... past its header              */
+  u32 n;                              /* ... records in it                */
+  const u8* data;                     /* corpus.dat                       */
+  size_t index_len, data_len;         /* Lengths of the mappings          */
+};
+
+static bool map_corpus(const std::string &dir, struct corpus_map* c) {
+
+  const u8* index = c->index = map_output(dir + CORPUS_INDEX, &c->index_len);
+
+  if (!index) return false;
+
+  if (c->index_len < 8 || ((u32*)index)[0] != CORPUS_MAGIC ||
+      ((u32*)index)[1] != CORPUS_VERSION) {
+    WARNF("'%s%s' is not a packed corpus", dir.c_str(), CORPUS_INDEX);
+    if (c->index_len) munmap((void*)index, c->index_len);
+    return false;
+  }
+
+  c->data = map_output(dir + CORPUS_DATA, &c->data_len);
+  if (!c->data) {
+    c->data = (const u8*)"";
+    c->data_len = 0;
+  }
+
+  c->recs = (const struct corpus_rec*)(index + 8);
+  c->n = (c->index_len - 8) / sizeof(struct corpus_rec);
+
+  while (c->n && c->recs[c->n - 1].offset + c->recs[c->n - 1].len > c->data_len)
+    c->n--;
+
+  return true;
+
+}
+
+static std::string corpus_name(const struct corpus_rec &r) {
+
+  return std::string(r.name, strnlen(r.name, sizeof(r.name)));
+
+}
+
+static void unmap_corpus(struct corpus_map* c) {
+
+  munmap((void*)c->index, c->index_len);
+  if (c->data_len) munmap((void*)c->data, c->data_len);
+
+}
+
+/* Queue the test cases of path: a packed corpus if there is one, the
+   files in it otherwise. Crashes and hangs stay out of the queue. */
+
+static void load_queue(const char* path) {
+
+  struct corpus_map c;
+
+  if (!map_corpus(path, &c)) {
+    list_dir(path);
+    return;
+  }
+
+  for (u32 i = 0; i < c.n; i++) {
+    const struct corpus_rec &r = c.recs[i];
+    if (r.flags & (CORPUS_CRASH | CORPUS_HANG)) continue;
+    add_to_queue(std::string(path) + corpus_name(r),
+                 std::string((const char*)c.data + r.offset, r.len));
+  }
+
+  unmap_corpus(&c);
+
+}
+
+/* -x: write out the test cases of the packed corpus in out_dir as the
+   files they would have been without -P. */
+
+static void export_corpus() {
+
+  struct corpus_map c;
+  u32 bad = 0;
+
+  if (!map_corpus(out_dir, &c))
+    FATAL("No packed corpus in '%s'", out_dir);
+
+  for (u32 i = 0; i < c.n; i++) {
+    const struct corpus_rec &r = c.recs[i];
+    std::string content((const char*)c.data + r.offset, r.len);
+    if (hash32(content.data(), content.size(), HASH_CONST) != r.cksum) bad++;
+    save_test_case(std::string(out_dir) + corpus_name(r), content);
+  }
+
+  unmap_corpus(&c);
+
+  if (bad) WARNF("%u test cases do not match their checksum.", bad);
+  OKF("Exported %u test cases to '%s'.", c.n, out_dir);
+
+}
+
+/* Corpus scheduling, as in AFL. For every byte of the map we keep the
+   entry that covers it at the lowest exec_us * len; cull_queue() favors a
+   small set of these champions that still covers everything, and
+   calculate_score() hands out energy (mutations in a row) so that fast,
+   small entries with rare edges get most of the executions. On targets
+   where a run costs seconds, that choice matters more than anything the
+   mutators do. */
+
+#define SCHED_EXECS 4                 /* Executions at perf score 100     */
+
+/* Count the bytes set in the map. */
+
+static u32 count_bytes(u8* mem) {
+
+  u32* ptr = (u32*)mem;
+  u32  i   = (MAP_SIZE >> 2);
+  u32  ret = 0;
+
+  while (i--) {
+
+    u32 v = *(ptr++);
+
+    if (!v) continue;
+    if (v & 0x000000ff) ret++;
+    if (v & 0x0000ff00) ret++;
+    if (v & 0x00ff0000) ret++;
+    if (v & 0xff000000) ret++;
+
+  }
+
+  return ret;
+
+}
+
+/* Record the trace of the last execution as a bitmap in q->trace_mini and
+   see if q becomes the top-rated entry for any of its bytes. trace_bits
+   must be classified already. Unlike AFL we keep trace_mini for every
+   entry, calculate_score() needs it to find rare edges; corpora of
+   targets this slow stay small. An entry is counted in the totals and in
+   edge_freq once, on its first trace; a later call only has it compete
+   for top_rated again. */
+
+static void update_bitmap_score(struct queue_entry* q) {
+
+  u64 fav_factor = q->exec_us * q->len;
+  bool first = !q->trace_mini;
+
+  if (first) {
+
+    q->bitmap_size = count_bytes(trace_bits);
+    if (!q->bitmap_size) return;
+
+    q->trace_mini = (u8*)calloc(MAP_SIZE >> 3, 1);
+
+    total_exec_us += q->exec_us;
+    total_bitmap_size += q->bitmap_size;
+    total_cal_entries++;
+
+  }
+
+  for (u32 i = 0; i < MAP_SIZE; i++) {
+
+    if (!trace_bits[i]) continue;
+
+    if (first) {
+      q->trace_mini[i >> 3] |= 1 << (i & 7);
+      edge_freq[i]++;
+    }
+
+    if (top_rated[i] &&
+        fav_factor > top_rated[i]->exec_us * top_rated[i]->len) continue;
+
+    if (top_rated[i] != q) {
+      if (top_rated[i]) top_rated[i]->tc_ref--;
+      top_rated[i] = q;
+      q->tc_ref++;
+      score_changed = 1;
+    }
+
+  }
+
+}
+
+/* Mark as favored a greedy subset of the top-rated entries that covers
+   every byte seen so far. Entries without a trace are favored as well:
+   seeds that were never run, and devcloud or hardware-only finds whose
+   value is in their metrics, not in the map. */
+
+static void cull_queue(void) {
+
+  static u8 temp_v[MAP_SIZE >> 3];
+
+  if (!score_changed) return;
+
+  score_changed = 0;
+  queued_favored = pending_favored = 0;
+
+  memset(temp_v, 0xff, MAP_SIZE >> 3);
+
+  for (auto q : input_queue) {
+    q->favored = !q->trace_mini || !q->has_new_cov;
+    if (q->favored) {
+      queued_favored++;
+      if (!q->was_fuzzed) pending_favored++;
+    }
+  }
+
+  for (u32 i = 0; i < MAP_SIZE; i++) {
+
+    struct queue_entry* q = top_rated[i];
+
+    if (!q || !(temp_v[i >> 3] & (1 << (i & 7)))) continue;
+
+    for (u32 j = 0; j < (MAP_SIZE >> 3); j++) temp_v[j] &= ~q->trace_mini[j];
+
+    if (!q->favored) {
+      q->favored = 1;
+      queued_favored++;
+      if (!q->was_fuzzed) pending_favored++;
+    }
+
+  }
+
+  for (auto q : input_queue) q->fs_redundant = !q->favored;
+
+}
+
+/* How often the rarest byte of q's trace is hit across the queue. */
+
+static u32 rarest_edge(struct queue_entry* q) {
+
+  u32 ret = UINT_MAX;
+
+  if (!q->trace_mini) return ret;
+
+  for (u32 i = 0; i < MAP_SIZE; i++)
+    if ((q->trace_mini[i >> 3] & (1 << (i & 7))) && edge_freq[i] < ret)
+      ret = edge_freq[i];
+
+  return ret;
+
+}
+
+/* Perf score of an entry, 100 being average: faster and bigger coverage
+   earn more, as do entries that came late to the queue (handicap), deep
+   ones, and ones that own an edge few others reach. */
+
+static u32 calculate_score(struct queue_entry* q) {
+
+  u32 perf_score = 100;
+
+  if (total_cal_entries && q->trace_mini) {
+
+    u64 avg_exec_us = total_exec_us / total_cal_entries;
+    u32 avg_bitmap_size = total_bitmap_size / total_cal_entries;
+
+    if (q->exec_us * 0.1 > avg_exec_us) perf_score = 10;
+    else if (q->exec_us * 0.25 > avg_exec_us) perf_score = 25;
+    else if (q->exec_us * 0.5 > avg_exec_us) perf_score = 50;
+    else if (q->exec_us * 0.75 > avg_exec_us) perf_score = 75;
+    else if (q->exec_us * 4 < avg_exec_us) perf_score = 300;
+    else if (q->exec_us * 3 < avg_exec_us) perf_score = 200;
+    else if (q->exec_us * 2 < avg_exec_us) perf_score = 150;
+
+    if (q->bitmap_size * 0.3 > avg_bitmap_size) perf_score *= 3;
+    else if (q->bitmap_size * 0.5 > avg_bitmap_size) perf_score *= 2;
+    else if (q->bitmap_size * 0.75 > avg_bitmap_size) perf_score *= 1.5;
+    else if (q->bitmap_size * 3 < avg_bitmap_size) perf_score *= 0.25;
+    else if (q->bitmap_size * 2 < avg_bitmap_size) perf_score *= 0.5;
+    else if (q->bitmap_size * 1.5 < avg_bitmap_size) perf_score *= 0.75;
+
+  }
+
+  if (q->handicap >= 4) {
+    perf_score *= 4;
+    q->handicap -= 4;
+  } else if (q->handicap) {
+    perf_score *= 2;
+    q->handicap--;
+  }
+
+  switch (q->depth) {
+    case 0 ... 3:   break;
+    case 4 ... 7:   perf_score *= 2; break;
+    case 8 ... 13:  perf_score *= 3; break;
+    case 14 ... 25: perf_score *= 4; break;
+    default:        perf_score *= 5;
+  }
+
+  u32 rare = rarest_edge(q);
+
+  if (rare == 1) perf_score *= 2;
+  else if (rare <= 3) perf_score *= 1.5;
+
+  if (perf_score > HAVOC_MAX_MULT * 100) perf_score = HAVOC_MAX_MULT * 100;
+
+  return perf_score;
+
+}
+
+/* Replay log. Instead of keeping every intermediate test case, we log
+   how each kept or crashing one was made, in out_dir/replay.bin:
+
+     "HFZR"  u32 version  u32 flags  u32 seeds  u64 worker seed
+     n x struct replay_rec
+
+   Together with the seeds in the input dir, that is enough to rebuild
+   any of them (-r). */
+
+#define REPLAY_FILE    "replay.bin"
+#define REPLAY_MAGIC   0x525a4648     /* "HFZR"                           */
+#define REPLAY_VERSION 1
+#define REPLAY_CRASH   0xffffffff     /* queue_id of crashes and hangs    */
+#define REPLAY_BINARY  1u             /* flags: -B                        */
+
+enum {
+  /* 00 */ REPLAY_MUTATE,             /* Test case made by mutate()       */
+  /* 01 */ REPLAY_TRIM                /* ... then trimmed, see trim_case() */
+};
+
+/* For REPLAY_TRIM records, parent and seed are the position and length
+   of the span trim_case() removed (in values for typed test cases, in
+   bytes otherwise). */
+
+struct replay_rec {
+  u32 id;                             /* case_origin.id                   */
+  u32 queue_id;                       /* Where it went in the queue       */
+  u32 parent;                         /* case_origin.parent               */
+  u8  knob, dev_knob;                 /* Host and device knob, 0 if none  */
+  u8  kind;                           /* REPLAY_*                         */
+  u8  variant;                        /* Kernel variant, 0 if none        */
+  u64 seed;                           /* case_origin.seed                 */
+};
+
+static s32 replay_fd = -1;            /* replay.bin                       */
+static u32 seed_cnt;                  /* Seeds at the head of the queue   */
+
+/* Start the replay log, or with keep, go on with the first keep bytes of
+   the one a resumed campaign left behind (see load_state()). */
+
+static void setup_replay_log(u64 keep = 0) {
+
+  std::string fn = std::string(out_dir) + REPLAY_FILE;
+  u32 hdr[4] = {REPLAY_MAGIC, REPLAY_VERSION, binary_inputs ? REPLAY_BINARY : 0,
+                seed_cnt};
+  struct stat st;
+
+  if (keep && !stat(fn.c_str(), &st) && (u64)st.st_size >= keep) {
+
+    replay_fd = open(fn.c_str(), O_WRONLY);
+    if (replay_fd < 0 || ftruncate(replay_fd, keep) ||
+        lseek(replay_fd, keep, SEEK_SET) < 0)
+      PFATAL("Unable to continue '%s'", fn.c_str());
+    return;
+
+  }
+
+  replay_fd = open(fn.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (replay_fd < 0) PFATAL("Unable to create '%s'", fn.c_str());
+
+  if (write(replay_fd, hdr, sizeof(hdr)) != sizeof(hdr) ||
+      write(replay_fd, &rng_seed, 8) != 8)
+    PFATAL("Short write to '%s'", fn.c_str());
+
+}
+
+static void log_replay(u32 queue_id) {
+
+  struct replay_rec rec = {cur_case.id, queue_id, cur_case.parent,
+                           (u8)(cur_case.host_arm + 1),
+                           (u8)(cur_case.dev_arm + 1), REPLAY_MUTATE,
+                           (u8)(cur_case.var_arm + 1),
+                           cur_case.seed};
+
+  if (replay_fd < 0) return;
+
+  if (write(replay_fd, &rec, sizeof(rec)) != sizeof(rec))
+    WARNF("Short write to the replay log");
+
+}
+
+/* Trimming. random_append_number() and friends only ever grow test
+   cases, and big ones are slower to parse, to copy to the device and to
+   run. Before a local find joins the queue, we remove spans of it (values
+   for typed test cases, bytes otherwise) as long as its coverage
+   checksum and hardware buckets (hw_features()) stay the same. Not the
+   behavior_key(): that has the exact metrics, time and all, and a cut
+   would hardly ever keep them. Devcloud finds are not trimmed, every
+   attempt would be another round of qsub jobs. */
+
+#define TRIM_MAX_EXECS 32             /* Trimming runs per test case      */
+
+static void apply_trim(std::string &content, std::vector<typed_value> &vals,
+                       bool typed, u32 pos, u32 len) {
+
+  if (typed) vals.erase(vals.begin() + pos, vals.begin() + pos + len);
+  else content.erase(pos, len);
+
+}
+
+static void trim_case(struct queue_entry* q) {
+
+  static u8 saved_trace[MAP_SIZE];
+
+  s32 feat[HW_FEATURES], cand_feat[HW_FEATURES];
+  std::string content((char*)q->mem, q->len);
+  std::vector<typed_value> vals;
+  parse_typed(content, vals);
+
+  bool typed = !vals.empty();
+  bool binary = binary_inputs || is_hfzb(content);
+  u32 n = typed ? vals.size() : content.size();
+  u32 min_len = typed ? 1 : TRIM_MIN_BYTES;
+  u32 orig_n = n, execs = 0, queue_id = input_queue.size() - 1;
+  bool divergent = !backends.empty() && last_divergent;
+
+  q->trim_done = 1;
+
+  if (n <= min_len) return;
+
+  memcpy(saved_trace, trace_bits, MAP_SIZE);
+  hw_features(&last_metrics, feat);
+
+  u32 remove_len = n / TRIM_START_STEPS;
+  if (remove_len < min_len) remove_len = min_len;
+
+  while (remove_len >= min_len && remove_len >= orig_n / TRIM_END_STEPS &&
+         execs < TRIM_MAX_EXECS) {
+
+    u32 remove_pos = remove_len;
+
+    while (remove_pos < n && execs < TRIM_MAX_EXECS) {
+
+      u32 trim_avail = MIN(remove_len, n - remove_pos);
+      std::string cand(content);
+      std::vector<typed_value> cand_vals(vals);
+      struct hfuzz_metrics m;
+
+      apply_trim(cand, cand_vals, typed, remove_pos, trim_avail);
+      if (typed) cand = emit_typed(cand_vals, binary);
+
+      u64 start_us = get_cur_time_us();
+      int fault = backends.empty() ? run_target(target_path, cand)
+                                   : run_backends(cand);
+      u64 exec_us = get_cur_time_us() - start_us;
+      telem_record(STAGE_TARGET, exec_us);
+      execs++;
+
+      classify_counts((u64*)trace_bits);
+      if (!load_metrics("", &m)) load_legacy_metrics("", &m);
+      hw_features(&m, cand_feat);
+
+      if (!fault && hash32(trace_bits, MAP_SIZE, HASH_CONST) == q->exec_cksum &&
+          !memcmp(feat, cand_feat, sizeof(feat)) &&
+          (backends.empty() || check_execution_divergent("") == divergent)) {
+
+        /* Keep the smaller version; log the cut so that -r can make it
+           again. */
+
+        struct replay_rec rec = {cur_case.id, queue_id, remove_pos, 0, 0,
+                                 REPLAY_TRIM, 0, trim_avail};
+
+        if (replay_fd >= 0 && write(replay_fd, &rec, sizeof(rec)) != sizeof(rec))
+          WARNF("Short write to the replay log");
+
+        content = cand;
+        vals.swap(cand_vals);
+        n -= trim_avail;
+
+      } else remove_pos += remove_len;
+
+    }
+
+    remove_len >>= 1;
+
+  }
+
+  memcpy(trace_bits, saved_trace, MAP_SIZE);
+
+  if (n == orig_n) return;
+
+  DEBUGF("trimmed %s from %u to %u %s in %u runs\n", q->fname, orig_n, n,
+         typed ? "values" : "bytes", execs);
+
+  free(q->mem);
+  q->len = content.size();
+  q->mem = (u8*)malloc(q->len + 1);
+  memcpy(q->mem, content.data(), q->len);
+
+  delete q->typed;
+  q->typed = NULL;
+
+  seen_inputs.insert(input_key(content));
+
+}
+
+/* Calibration. Every find runs HW_CAL_RUNS more times before it goes into
+   the queue. The runs tell us whether its trace is stable (var_behavior),
+   whether it runs at all twice (cal_failed), and what it takes on
+   average, both on the host (exec_us) and in the time we compete on.
+
+   That average is what the claims of hw_claim are checked against. A
+   find that rests on its time alone may be noise: a new time bucket has
+   to hold for the mean of the runs, and a cell taken from its incumbent
+   has to be slower by a one-sided Welch t-test at 95%, mean and variance
+   against the incumbent's own. Devcloud jobs cost far too much to repeat
+   and cache hits have nothing to rerun; both keep their single run. */
+
+#define HW_CAL_RUNS    4              /* Extra runs of a find             */
+
+struct cal_result {
+  double mean, var;                   /* Time over the runs (hw_perf())   */
+  u32 n;                              /* ... how many runs reported one   */
+  u64 exec_us;                        /* Mean execution time (us)         */
+  bool failed;                        /* A run faulted                    */
+  bool variable;                      /* The trace changed between runs   */
+};
+
+static void calibrate_case(const std::string &content, struct cal_result* cal) {
+
+  static u8 saved_trace[MAP_SIZE];
+
+  u32 cksum = hash32(trace_bits, MAP_SIZE, HASH_CONST);
+  u32 saved_hw_key = cur_hw_key;
+  u64 total_us = cur_exec_us, runs = 1;
+  double t, mean = 0, m2 = 0;
+
+  memset(cal, 0, sizeof(*cal));
+  if (hw_perf(&last_metrics, &t)) {
+    mean = t;
+    cal->n = 1;
+  }
+
+  memcpy(saved_trace, trace_bits, MAP_SIZE);
+
+  for (u32 i = 0; i < HW_CAL_RUNS; i++) {
+
+    struct hfuzz_metrics m;
+
+    u64 start_us = get_cur_time_us();
+    int fault = backends.empty() ? run_target(target_path, content)
+                                 : run_backends(content);
+    u64 exec_us = get_cur_time_us() - start_us;
+    telem_record(STAGE_TARGET, exec_us);
+
+    if (fault) {
+      cal->failed = 1;
+      break;
+    }
+
+    total_us += exec_us;
+    runs++;
+
+    classify_counts((u64*)trace_bits);
+    if (hash32(trace_bits, MAP_SIZE, HASH_CONST) != cksum) cal->variable = 1;
+
+    if (!load_metrics("", &m)) load_legacy_metrics("", &m);
+    if (!hw_perf(&m, &t)) continue;
+
+    /* Welford's running mean and variance. */
+
+    double d = t - mean;
+    cal->n++;
+    mean += d / cal->n;
+    m2 += d * (t - mean);
+
+  }
+
+  memcpy(trace_bits, saved_trace, MAP_SIZE);
+  cur_hw_key = saved_hw_key;
+
+  cal->mean = mean;
+  cal->var = cal->n > 1 ? m2 / (cal->n - 1) : 0;
+  cal->exec_us = total_us / runs;
+
+  DEBUGF("calibrated: time %lf +- %lf over %u runs%s%s\n", cal->mean,
+         sqrt(cal->var), cal->n, cal->variable ? ", variable trace" : "",
+         cal->failed ? ", faulted" : "");
+
+}
+
+/* One-sided 95% quantile of Student's t with df degrees of freedom; past
+   the table, the value for the low end of each range. */
+
+static double t_crit95(double df) {
+
+  static const double t[10] = { 6.314, 2.920, 2.353, 2.132, 2.015,
+                                1.943, 1.895, 1.860, 1.833, 1.812 };
+
+  if (df < 1) df = 1;
+  if (df <= 10) return t[(int)df - 1];
+  if (df <= 30) return 1.796;
+  return 1.697;
+
+}
+
+/* Is the calibrated time significantly slower than the incumbent e? An
+   incumbent of a single run (devcloud, cache hits) has no variance of
+   its own; it is taken to be as noisy as we are. */
+
+static bool slower_than(const struct cal_result* cal, const struct hw_elite* e) {
+
+  if (cal->mean <= e->mean * HW_ELITE_MARGIN) return false;
+  if (cal->n < 2) return true;
+
+  double v0 = e->n > 1 ? e->var : cal->var;
+  double s1 = cal->var / cal->n, s0 = v0 / e->n, se2 = s1 + s0;
+
+  if (se2 <= 0) return true;
+
+  double df = e->n > 1 ? se2 * se2 / (s1 * s1 / (cal->n - 1) +
+                                      s0 * s0 / (e->n - 1))
+                       : cal->n - 1;
+
+  return (cal->mean - e->mean) / sqrt(se2) > t_crit95(df);
+
+}
+
+/* Hold the time claims of the last check_new_hardware() against the
+   calibrated runs; the ones that don't stand are rolled back. Returns
+   false if that leaves nothing to keep the test case for. */
+
+static bool settle_hw_claim(const struct cal_result* cal, int interest) {
+
+  bool keep = interest != NEW_HARDWARE || hw_claim.other;
+
+  if (hw_claim.time_bucket >= 0) {
+
+    u8 b = cal->n > 1 ? hw_bucket(cal->mean) : hw_claim.time_bucket;
+
+    if (b == hw_claim.time_bucket || !hw_virgin[0][b]) keep = 1;
+    else {
+      DEBUGF("time bucket %d was noise\n", hw_claim.time_bucket);
+      hw_virgin[0][hw_claim.time_bucket] = 0;
+      hw_buckets_hit--;
+    }
+
+  }
+
+  if (hw_claim.cell) {
+
+    struct hw_elite &e = hw_elites[hw_claim.cell_id];
+
+    if (!hw_claim.had_prev || slower_than(cal, &hw_claim.prev)) {
+      e = {cal->n ? cal->mean : hw_claim.perf, cal->var, cal->n ? cal->n : 1};
+      keep = 1;
+    } else {
+      DEBUGF("slowdown for hardware cell %08x is not significant\n",
+             hw_claim.cell_id);
+      e = hw_claim.prev;
+    }
+
+  }
+
+  return keep;
+
+}
+
+/* Keep the test case if it is interesting: it goes to the output dir as
+   fname plus a suffix saying why, and into the queue. */
+
+void write_to_test(const std::string &fname, const std::string &content, int interest){
+  
+  if(!interest) return;
+
+  /* Hardware metrics can flag a test case whose trace and hardware
+     behavior we already have in the queue; that is a clone, count it
+     against the original instead of keeping it. */
+
+  u64 behavior = behavior_key();
+  auto b = seen_behavior.find(behavior);
+
+  if (b != seen_behavior.end()) {
+    b->second++;
+    skipped_clones++;
+    DEBUGF("skipped clone of a known behavior (%u so far)\n", b->second);
+    return;
+  }
+
+  struct cal_result cal;
+  bool calibrated = !devcloud_jobs() && !cache_replay;
+
+  if (calibrated) {
+    calibrate_case(content, &cal);
+    if (!settle_hw_claim(&cal, interest)) {
+      slow_rejected++;
+      return;
+    }
+  }
+
+  seen_behavior[behavior] = 0;
+
+  std::string new_name; 
+  if(interest == NEW_COVERAGE) new_name = fname + "_cov";
+  else if(interest == NEW_HARDWARE) new_name = fname + "_hd";
+  else if(interest == NEW_BOTH) new_name = fname + "_both";
+
+  struct queue_entry *q = add_to_queue(new_name, content);
+  q->exec_cksum = hash32(trace_bits, MAP_SIZE, HASH_CONST);
+  q->behavior = behavior;
+  if(interest != NEW_HARDWARE) q->has_new_cov = 1;
+  q->exec_us = calibrated ? cal.exec_us : cur_exec_us;
+  q->depth = cur_case.depth + 1;
+  q->handicap = queue_cycle ? queue_cycle - 1 : 0;
+  if (calibrated) {
+    q->cal_failed = cal.failed;
+    q->var_behavior = cal.variable;
+  }
+  log_replay(input_queue.size() - 1);
+
+  /* Trim before the entry competes for top_rated, so it does so with its
+     final size and speed. Trimming keeps cuts that preserve the behavior,
+     which means nothing for an entry that does not repeat its own. A find
+     re-run on resume was trimmed the first time. */
+
+  if (!devcloud_jobs() && !q->cal_failed && !q->var_behavior && !resume_import)
+    trim_case(q);
+
+  store_test_case(new_name, std::string((char*)q->mem, q->len),
+                  (interest != NEW_HARDWARE ? CORPUS_COV : 0) |
+                  (interest != NEW_COVERAGE ? CORPUS_HW : 0), q);
+
+  update_bitmap_score(q);
+  score_changed = 1;
+  
+}
+
+void write_to_test(const std::string &fname, const std::string &content){
+  store_test_case(fname + "_crash", content, CORPUS_CRASH, NULL);
+  log_replay(REPLAY_CRASH);
+  telem_crashes.fetch_add(1, std::memory_order_relaxed);
+}
+
+/* A run that hit the timeout. What the killed target got through is in
+   the trace, and a hang is kept only if that reaches something no hang
+   before it did: endless loops tend to be the same few loops. Returns
+   true if it was kept. */
+
+static bool save_hang(const std::string &fname, const std::string &content) {
+
+  classify_counts((u64*)trace_bits);
+
+  if (!has_new_bits(virgin_tmout)) {
+    skipped_hangs++;
+    return false;
+  }
+
+  store_test_case(fname + "_hang", content, CORPUS_HANG, NULL);
+  log_replay(REPLAY_CRASH);
+  telem_hangs.fetch_add(1, std::memory_order_relaxed);
+  return true;
+
+}
+
+/* Selective invocation. A devcloud job (or a round of -D backends) costs
+   orders of magnitude more than anything else we do, and most of them come
+   back with nothing new. Before paying for one, a few cheap features of the
+   test case go through an online logistic model, trained on the outcome of
+   every expensive run so far: did it reach a new hardware bucket (or
+   diverge)? Test cases the model rates at less than half the running find
+   rate are dropped, except for a fraction (-E) that is run anyway, so that the
+   model keeps seeing the kind of input it would reject. */
+
+#define FILTER_FEATURES 10
+#define FILTER_WARMUP   32            /* Runs to learn from before filtering */
+#define FILTER_STEP     0.1           /* SGD learning rate                   */
+#define FILTER_MARGIN   0.5           /* Share of the find rate to dispatch  */
+
+static double filter_w[FILTER_FEATURES];      /* Model weights            */
+static double cur_feat[FILTER_FEATURES];      /* Features of the test case */
+static u64 filter_runs,                       /* Expensive runs learned   */
+           filter_finds,                      /* ... that found something */
+           filter_skipped,                    /* Test cases not run       */
+           filter_explored;                   /* ... run despite the model */
+
+static inline double signed_log(double v) {
+  return v < 0 ? -log2(1 - v) : log2(1 + v);
+}
+
+/* Features: bias, length, value range, mean magnitude, and the fractions
+   of zeros, NaNs, Infs and negatives. Test cases that don't parse as
+   numbers only get the bias and their length. */
+
+static void filter_features(const std::string &content, double* x) {
+
+  std::vector<typed_value> vals;
+  double lo = INFINITY, hi = -INFINITY, mag = 0;
+  u32 zeros = 0, nans = 0, infs = 0, negs = 0, finite;
+
+  memset(x, 0, FILTER_FEATURES * sizeof(double));
+  x[0] = 1;
+
+  parse_typed(content, vals);
+  x[1] = log2(1.0 + (vals.empty() ? content.size() : vals.size())) / 16;
+  if (vals.empty()) return;
+
+  for (auto &v : vals) {
+
+    double d = v.type == T_I64 ? (double)v.i : v.f;
+
+    if (std::isnan(d)) { nans++; continue; }
+    if (d < 0) negs++;
+    if (std::isinf(d)) { infs++; continue; }
+    if (d == 0) zeros++;
+
+    if (d < lo) lo = d;
+    if (d > hi) hi = d;
+    mag += log2(1 + fabs(d));
+
+  }
+
+  finite = vals.size() - nans - infs;
+
+  if (finite) {
+    x[2] = signed_log(lo) / 128;
+    x[3] = signed_log(hi) / 128;
+    x[4] = mag / finite / 128;
+  }
+
+  x[5] = (double)zeros / vals.size();
+  x[6] = (double)nans / vals.size();
+  x[7] = (double)infs / vals.size();
+  x[8] = (double)negs / vals.size();
+  x[9] = 1;                           /* Typed */
+
+}
+
+static double filter_predict(const double* x) {
+
+  double z = 0;
+
+  for (u32 i = 0; i < FILTER_FEATURES; i++) z += filter_w[i] * x[i];
+
+  return 1 / (1 + exp(-z));
+
+}
+
+/* One SGD step on the outcome of an expensive run. */
+
+static void filter_learn(const double* x, bool found) {
+
+  double err = found - filter_predict(x);
+
+  for (u32 i = 0; i < FILTER_FEATURES; i++) filter_w[i] += FILTER_STEP * err * x[i];
+
+  filter_runs++;
+  filter_finds += found;
+
+}
+
+/* Decide whether a test case is worth an expensive run. Leaves its
+   features in cur_feat for filter_learn(). Plain local runs are cheap and
+   always go ahead. */
+
+static bool worthy_simulation(const std::string &content) {
+
+  if (!devcloud_jobs() && backends.empty()) return true;
+
+  filter_features(content, cur_feat);
+
+  if (filter_runs < FILTER_WARMUP) return true;
+
+  if (filter_predict(cur_feat) >=
+      FILTER_MARGIN * filter_finds / filter_runs) return true;
+
+  if (rng_next(rng_worker) % 1000 < explore_rate * 1000) {
+    filter_explored++;
+    return true;
+  }
+
+  filter_skipped++;
+  return false;
+
+}
+
+/* Devcloud job scheduler. Hardware runs are qsub jobs on FPGA and GPU
+   nodes; rather than submitting one input and sleeping a fixed time, we
+   keep up to max_hw_jobs jobs in flight across a pool of nodes, poll qstat
+   and evaluate every input as soon as all of its jobs have left the queue.
+   Each input gets its own job directory (qsub -d), so the reports the
+   target writes there (exec_fpga_info.txt, gpu.txt, ...) can't collide. */
+
+enum {
+  /* 00 */ HW_FPGA,
+  /* 01 */ HW_GPU
+};
+
+struct hw_node {
+  std::string spec;                   /* qsub nodes= resource             */
+  u8 kind;                            /* HW_FPGA or HW_GPU                */
+  u32 busy;                           /* Jobs in flight on this node      */
+};
+
+struct hw_job {
+  std::string id;                     /* Job id printed by qsub           */
+  hw_node* node;                      /* Node the job was submitted to    */
+};
+
+struct hw_request {
+  std::string input;                  /* Name to save the test case as    */
+  std::string content;                /* Test case contents               */
+  std::string dir;                    /* Job directory with the reports   */
+  std::vector<hw_job> jobs;           /* Jobs still in flight             */
+  u64 submit_time;                    /* When the first job went out (ms) */
+  struct case_origin origin;          /* Where the test case came from    */
+  double feat[FILTER_FEATURES];       /* Filter features, see filter_learn() */
+};
+
+static std::vector<hw_node> hw_nodes;          /* FPGA and GPU node pool  */
+static std::vector<hw_request*> hw_inflight;   /* Inputs awaiting results */
+static u32 hw_jobs_inflight;                   /* qsub jobs in flight     */
+static u64 hw_last_poll;                       /* Last qstat poll (ms)    */
+static u32 hw_req_id;                          /* Next job directory      */
+
+#define HW_POLL_MS 2000                        /* qstat poll interval     */
+
+static inline bool devcloud_jobs() {
+  return devcloud_fpga_enable || devcloud_fpga_hd_enable;
+}
+
+/* Split the comma-separated -N / -G lists into the node pool. */
+
+static void setup_hw_nodes() {
+
+  const char* lists[] = {fpga_node_list, gpu_node_list};
+
+  for (u8 kind = HW_FPGA; kind <= HW_GPU; kind++) {
+
+    std::string list(lists[kind]);
+    size_t pos = 0;
+
+    while (pos <= list.size()) {
+      size_t end = list.find(',', pos);
+      if (end == std::string::npos) end = list.size();
+      if (end > pos) hw_nodes.push_back({list.substr(pos, end - pos), kind, 0});
+      pos = end + 1;
+    }
+
+  }
+
+  OKF("Devcloud pool: %u nodes, up to %u jobs in flight.",
+      (u32)hw_nodes.size(), max_hw_jobs);
+
+}
+
+/* The least busy node of the given kind, or NULL if the pool has none. */
+
+static hw_node* pick_hw_node(u8 kind) {
+
+  hw_node* best = NULL;
+
+  for (auto &n : hw_nodes)
+    if (n.kind == kind && (!best || n.busy < best->busy)) best = &n;
+
+  return best;
+
+}
+
+/* Run a command and return the first line it prints on stdout. */
+
+static std::string popen_line(const std::string &cmd) {
+
+  char buf[512] = {0};
+  FILE* f = popen(cmd.c_str(), "r");
+
+  if (!f) return "";
+
+  if (!fgets(buf, sizeof(buf), f)) buf[0] = 0;
+  pclose(f);
+
+  buf[strcspn(buf, "\r\n")] = 0;
+  return std::string(buf);
+
+}
+
+/* Remove a job directory and the reports in it. */
+
+static void remove_job_dir(const std::string &dir) {
+
+  struct dirent* entry;
+  DIR* d = opendir(dir.c_str());
+
+  if (!d) return;
+
+  while ((entry = readdir(d)) != NULL) {
+    if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) continue;
+    unlink((dir + entry->d_name).c_str());
+  }
+
+  closedir(d);
+  rmdir(dir.c_str());
+
+}
+
+/* Evaluate a request whose jobs have all finished. There is no coverage
+   for remote runs, only the hardware reports in the job directory. */
+
+static void hw_complete(hw_request* r) {
+
+  int interest;
+  struct case_origin origin = cur_case;
+
+  DEBUGF("hardware results for %s after %llu ms\n", r->input.c_str(),
+         get_cur_time() - r->submit_time);
+
+  memset(trace_bits, 0, MAP_SIZE);
+  cache_snapshot();
+
+  interest = save_if_interest(r->dir);
+  DEBUGF("the current input is interest: %d\n", interest);
+
+  /* Credit the find to the entry (and latency) it came from. */
+
+  cur_case = r->origin;
+  cur_exec_us = (get_cur_time() - r->submit_time) * 1000;
+  telem_record(STAGE_TARGET, cur_exec_us);
+  cache_store(r->content, FAULT_NONE, r->dir);
+  write_to_test(r->input, r->content, interest);
+  reward_arms(cur_case, interest != NOT_INTEREST, cur_exec_us);
+  filter_learn(r->feat, interest == NEW_HARDWARE || interest == NEW_BOTH);
+  cur_case = origin;
+
+  remove_job_dir(r->dir);
+  delete r;
+
+}
+
+/* Poll qstat for all jobs in flight and complete the inputs whose jobs are
+   gone (or in state C). With block set, wait until at least one input has
+   completed, or until we are told to stop. Returns the number of
+   completed inputs. */
+
+static u32 hw_poll(bool block) {
+
+  u32 done = 0;
+
+  while (!hw_inflight.empty()) {
+
+    u64 now = get_cur_time();
+
+    if (now - hw_last_poll < HW_POLL_MS) {
+      if (!block || done || stop_soon) break;
+      usleep((HW_POLL_MS - (now - hw_last_poll)) * 1000);
+      continue;
+    }
+
+    hw_last_poll = now;
+
+    /* Ask about all of our jobs in one go; finished jobs either drop out
+       of the listing or are reported as completed. */
+
+    std::string cmd = "qstat";
+    for (auto r : hw_inflight)
+      for (auto &j : r->jobs) cmd += " " + j.id;
+    cmd += " 2>/dev/null";
+
+    std::vector<std::string> running;
+    char line[512];
+    FILE* f = popen(cmd.c_str(), "r");
+
+    if (f) {
+
+      while (fgets(line, sizeof(line), f)) {
+
+        char id[256], state[16];
+
+        /* Job ID  Name  User  Time Use  S  Queue */
+
+        if (sscanf(line, "%255s %*s %*s %*s %15s", id, state) != 2) continue;
+        if (!isdigit(id[0]) || !strcmp(state, "C")) continue;
+
+        running.push_back(std::string(id, strcspn(id, ".")));
+
+      }
+
+      pclose(f);
+
+    }
+
+    for (size_t i = 0; i < hw_inflight.size(); ) {
+
+      hw_request* r = hw_inflight[i];
+
+      for (size_t k = 0; k < r->jobs.size(); ) {
+
+        std::string num = r->jobs[k].id.substr(0, strcspn(r->jobs[k].id.c_str(), "."));
+        bool alive = false;
+
+        for (auto &id : running) if (id == num) alive = true;
+
+        if (alive) { k++; continue; }
+
+        r->jobs[k].node->busy--;
+        hw_jobs_inflight--;
+        r->jobs.erase(r->jobs.begin() + k);
+
+      }
+
+      if (r->jobs.empty()) {
+        hw_inflight.erase(hw_inflight.begin() + i);
+        hw_complete(r);
+        done++;
+      } else i++;
+
+    }
+
+    if (!block || done || stop_soon) break;
+
+  }
+
+  return done;
+
+}
+
+/* Submit the FPGA and GPU jobs for one input. Blocks (while harvesting
+   results) only when the pool is saturated. The job scripts are expected
+   at <app>-fpga.sh and <app>-gpu.sh and find the test case in
+   $HFUZZ_INPUT. Remote nodes can't see our memfd, so the test case is
+   written to the job directory. Told to stop while waiting for room, we
+   submit nothing: the input stays in hw_inflight without jobs, and goes
+   into the checkpoint with the rest. */
+
+static void hw_dispatch(char* app, const std::string &fname,
+                        const std::string &content) {
+
+  const char* scripts[] = {"-fpga.sh", "-gpu.sh"};
+
+  while (hw_jobs_inflight + 2 > max_hw_jobs && !hw_inflight.empty() &&
+         !stop_soon)
+    hw_poll(1);
+
+  hw_request* r = new hw_request;
+
+  r->input = fname;
+  r->content = content;
+  r->dir = std::string(out_dir) + ".jobs/" + std::to_string(hw_req_id++) + "/";
+  r->submit_time = get_cur_time();
+  r->origin = cur_case;
+  memcpy(r->feat, cur_feat, sizeof(r->feat));
+
+  if (stop_soon) {
+    hw_inflight.push_back(r);
+    return;
+  }
+
+  mkdir((std::string(out_dir) + ".jobs").c_str(), 0700);
+  if (mkdir(r->dir.c_str(), 0700) && errno != EEXIST)
+    PFATAL("Unable to create '%s'", r->dir.c_str());
+
+  /* Jobs run on other nodes with their own working directory, so they
+     need absolute paths. */
+
+  char abs_dir[PATH_MAX];
+  if (!realpath(r->dir.c_str(), abs_dir))
+    PFATAL("Unable to resolve '%s'", r->dir.c_str());
+
+  save_test_case(r->dir + "input", content);
+
+  for (u8 kind = HW_FPGA; kind <= HW_GPU; kind++) {
+
+    hw_node* node = pick_hw_node(kind);
+    if (!node) continue;
+
+    std::string cmd = "qsub -l nodes=" + node->spec + " -d " +
+                      std::string(abs_dir) + " -v HFUZZ_INPUT=" +
+                      std::string(abs_dir) + "/input," KNOB_ENV_VAR "=" +
+                      std::to_string(cur_case.dev_arm + 1) + "," VARIANT_ENV_VAR "=" +
+                      std::to_string(cur_case.var_arm + 1) + "," SEED_ENV_VAR "=" +
+                      std::to_string(cur_case.seed) + " " + std::string(app) +
+                      scripts[kind];
+
+    std::string id = popen_line(cmd);
+
+    if (id.empty() || !isdigit(id[0])) {
+      WARNF("qsub failed for '%s'", cmd.c_str());
+      continue;
+    }
+
+    DEBUGF("submitted %s to %s\n", id.c_str(), node->spec.c_str());
+
+    node->busy++;
+    hw_jobs_inflight++;
+    r->jobs.push_back({id, node});
+
+  }
+
+  hw_inflight.push_back(r);
+
+  /* Nothing got submitted, evaluate (and drop) it right away. */
+
+  if (r->jobs.empty()) {
+    hw_inflight.pop_back();
+    hw_complete(r);
+  }
+
+}
+
+/* Wait for every input still in flight. */
+
+static void hw_drain() {
+
+  if (!hw_inflight.empty())
+    ACTF("Waiting for %u devcloud jobs to finish...", hw_jobs_inflight);
+
+  while (!hw_inflight.empty()) hw_poll(1);
+
+}
+
+/* Run one test case (locally, or as devcloud jobs) and file it according
+   to what it found. Only test cases worth keeping are written to disk,
+   as fname plus a suffix. */
+
+static void common_fuzz_stuff(char* app, const std::string &fname,
+                              const std::string &content) {
+
+  u64 dispatch_us = get_cur_time_us();
+
+  /* A repeat costs no execution, but it was still a wasted pull. So is a
+     test case the filter turned down. */
+
+  if(is_dup_input(content)) {
+    reward_arms(cur_case, 0, 0);
+    return;
+  }
+
+  /* An earlier campaign ran it: evaluate what it found back then. */
+
+  struct cache_rec hit;
+
+  if(cache_lookup(content, &hit)) {
+
+    DEBUGF("%s answered from the result cache\n", fname.c_str());
+    cur_exec_us = hit.exec_us;
+    cache_replay = 1;
+
+    if(hit.fault){
+      write_to_test(fname, content);
+      reward_arms(cur_case, 1, 0);
+    }else{
+      int interest = save_if_interest();
+      write_to_test(fname, content, interest);
+      reward_arms(cur_case, interest != NOT_INTEREST, 0);
+    }
+
+    cache_replay = 0;
+    return;
+
+  }
+
+  if(!worthy_simulation(content)) {
+    reward_arms(cur_case, 0, 0);
+    return;
+  }
+
+  if(devcloud_jobs()){
+    /* Results of earlier inputs are evaluated as they come in. */
+    hw_poll(0);
+    hw_dispatch(app, fname, content);
+    telem_record(STAGE_DISPATCH, get_cur_time_us() - dispatch_us);
+  }
+  else{
+    u64 start_us = get_cur_time_us();
+    telem_record(STAGE_DISPATCH, start_us - dispatch_us);
+    int crash = backends.empty() ? run_target(app, content)
+                                 : run_backends(content);
+    cur_exec_us = get_cur_time_us() - start_us;
+    telem_record(STAGE_TARGET, cur_exec_us);
+    cache_snapshot();
+
+    if(crash == FAULT_TMOUT){
+      bool found = save_hang(fname, content);
+      reward_arms(cur_case, found, cur_exec_us);
+    }else if(crash){ //if found crash
+      cache_store(content, crash, "");
+      write_to_test(fname, content);
+      reward_arms(cur_case, 1, cur_exec_us);
+      if (!backends.empty()) filter_learn(cur_feat, 1);
+    }else{  // else check the guidance
+      int interest = save_if_interest();
+      DEBUGF("the current input is interest: %d\n", interest);
+      cache_store(content, FAULT_NONE, "");
+      write_to_test(fname, content, interest);
+      reward_arms(cur_case, interest != NOT_INTEREST, cur_exec_us);
+      if (!backends.empty())
+        filter_learn(cur_feat, interest == NEW_HARDWARE || interest == NEW_BOTH);
+      }
+    }
+
+}
+
+/* Parallel fuzzing. With -M / -S, the output dir is a sync dir shared by
+   all workers and each worker keeps its findings in its own subdirectory.
+   Every SYNC_ITERATIONS iterations a worker looks at the new findings of
+   its peers and runs them itself; whatever is interesting locally goes
+   into its own queue, which merges coverage across the workers. */
+
+#define SYNC_ITERATIONS 100
+
+static char* sync_id;                 /* Worker name, -M / -S             */
+static bool main_worker;              /* -M rather than -S                */
+static std::string sync_dir;          /* Dir shared by all workers        */
+static s32 cpu_to_bind = -1;          /* -b                               */
+
+/* Our own findings are "<iteration>_cov", "_hd" or "_both"; anything else
+   (crashes, inputs imported from a peer, in-flight test cases) is not for
+   export. Returns the iteration, or -1. */
+
+static s64 sync_candidate(const char* name) {
+
+  char* end;
+
+  if (!isdigit(name[0])) return -1;
+
+  s64 id = strtoll(name, &end, 10);
+
+  if (strcmp(end, "_cov") && strcmp(end, "_hd") && strcmp(end, "_both"))
+    return -1;
+
+  return id;
+
+}
+
+/* Grab the new findings of all other workers. */
+
+static void sync_fuzzers(char* app) {
+
+  struct dirent* sd_ent;
+  DIR* sd = opendir(sync_dir.c_str());
+
+  if (!sd) PFATAL("Unable to open '%s'", sync_dir.c_str());
+
+  while ((sd_ent = readdir(sd))) {
+
+    struct dirent* qd_ent;
+    u32 imported = 0;
+
+    if (sd_ent->d_name[0] == '.' || !strcmp(sd_ent->d_name, sync_id))
+      continue;
+
+    std::string peer_dir = sync_dir + sd_ent->d_name + "/";
+    DIR* qd = NULL;
+    struct corpus_map c;
+    bool packed = map_corpus(peer_dir, &c);
+
+    if (!packed && !(qd = opendir(peer_dir.c_str()))) continue;
+
+    /* We keep the highest iteration seen so far for each peer; for a peer
+       with a packed corpus, the number of records. */
+
+    std::string id_fn = std::string(out_dir) + ".synced/" + sd_ent->d_name;
+    s64 last_seen = -1, max_seen;
+    FILE* id_f = fopen(id_fn.c_str(), "r");
+
+    if (id_f) {
+      if (fscanf(id_f, "%lld", (long long*)&last_seen) != 1) last_seen = -1;
+      fclose(id_f);
+    }
+
+    max_seen = last_seen;
+
+    for (u32 i = last_seen + 1; packed && i < c.n; i++) {
+
+      const struct corpus_rec &r = c.recs[i];
+
+      max_seen = i;
+      if (!(r.flags & (CORPUS_COV | CORPUS_HW)) || (r.flags & CORPUS_SYNC))
+        continue;
+
+      common_fuzz_stuff(app, std::string(out_dir) + "sync-" + sd_ent->d_name +
+                        "-" + corpus_name(r),
+                        std::string((const char*)c.data + r.offset, r.len));
+      imported++;
+
+    }
+
+    while (qd && (qd_ent = readdir(qd))) {
+
+      s64 id = sync_candidate(qd_ent->d_name);
+
+      if (id <= last_seen) continue;
+      if (id > max_seen) max_seen = id;
+
+      std::ifstream src(peer_dir + qd_ent->d_name, std::ios::binary);
+      if (!src.is_open()) continue;
+
+      std::string content( (std::istreambuf_iterator<char>(src) ),
+                           (std::istreambuf_iterator<char>()    ) );
+
+      common_fuzz_stuff(app, std::string(out_dir) + "sync-" + sd_ent->d_name +
+                        "-" + qd_ent->d_name, content);
+      imported++;
+
+    }
+
+    if (qd) closedir(qd);
+    if (packed) unmap_corpus(&c);
+
+    if (imported) DEBUGF("synced %u inputs from %s\n", imported, sd_ent->d_name);
+
+    id_f = fopen(id_fn.c_str(), "w");
+    if (!id_f) PFATAL("Unable to create '%s'", id_fn.c_str());
+    fprintf(id_f, "%lld\n", (long long)max_seen);
+    fclose(id_f);
+
+  }
+
+  closedir(sd);
+
+}
+
+/* Turn the output dir into a sync dir and move into our worker dir. */
+
+static void setup_sync_dir() {
+
+  if (strchr(sync_id, '/') || sync_id[0] == '.')
+    FATAL("Worker ID '%s' is not a valid directory name", sync_id);
+
+  sync_dir = std::string(out_dir);
+  if (sync_dir.empty() || sync_dir.back() != '/') sync_dir += "/";
+
+  std::string worker_dir = sync_dir + sync_id + "/";
+
+  if (worker_dir.size() >= sizeof(out_dir))
+    FATAL("Output path too long");
+
+  mkdir(sync_dir.c_str(), 0700);
+  if (mkdir(worker_dir.c_str(), 0700) && errno != EEXIST)
+    PFATAL("Unable to create '%s'", worker_dir.c_str());
+  mkdir((worker_dir + ".synced").c_str(), 0700);
+
+  memset(out_dir, 0, sizeof(out_dir));
+  memcpy(out_dir, worker_dir.c_str(), worker_dir.size());
+
+  OKF("Worker '%s' (%s) uses '%s'.", sync_id, main_worker ? "main" : "secondary",
+      out_dir);
+
+}
+
+/* Pin ourselves to one CPU (-b). */
+
+static void bind_to_cpu() {
+
+  cpu_set_t c;
+
+  CPU_ZERO(&c);
+  CPU_SET(cpu_to_bind, &c);
+
+  if (sched_setaffinity(0, sizeof(c), &c))
+    PFATAL("sched_setaffinity failed for CPU %d", cpu_to_bind);
+
+  OKF("Bound to CPU %d.", cpu_to_bind);
+
+}
+
+/* Checkpoints. Devcloud jobs run under a walltime limit, and everything
+   the campaign learned lives in memory: the virgin maps, the queue with
+   its traces and scheduling state, the hardware buckets and cells, the
+   bandits, the filter model and the dedup indexes. Every CKPT_INTERVAL ms,
+   and when a signal stops us, all of it goes to out_dir/fuzzer_state:
+
+     struct ckpt_hdr
+     virgin_bits, virgin_tmout, hw_virgin, the arms, filter_w
+     elites x { u64 cell, struct hw_elite }
+     behaviors x { u64 key, u32 clones }
+     inputs x u64
+     entries x { struct ckpt_entry, name, contents, trace_mini if any }
+     requests x { struct ckpt_req, name, contents }
+
+   It is written under a temporary name and renamed into place, so that
+   a kill halfway leaves the previous one. -resume maps it back and goes
+   on where it left off, without a dry run. The replay log and the packed
+   corpus are cut back to where they were at the checkpoint, and the finds
+   made after it are run again (see import_lost_finds()); most of them are
+   result cache hits by then. Devcloud inputs that were in flight are
+   submitted again. max_trials counts the iterations of all runs. */
+
+#define CKPT_FILE      "fuzzer_state"
+#define CKPT_MAGIC     0x535a4648     /* "HFZS"                           */
+#define CKPT_VERSION   1
+#define CKPT_INTERVAL  (60 * 1000)    /* Between checkpoints (ms)         */
+
+struct ckpt_hdr {
+  u32 magic, version;
+  u64 config;                         /* cache_config() of the campaign   */
+  u64 taken;                          /* Unix time (ms)                   */
+  u64 rng_seed, rng_worker[4];
+  u32 seed_cnt, entries, elites, behaviors;
+  u64 inputs;                         /* Entries of seen_inputs           */
+  u32 requests;                       /* Devcloud inputs in flight        */
+  u32 num_variants;
+  s32 iter;                           /* Next fuzzing iteration           */
+  u32 cur;                            /* Next queue entry                 */
+  u32 exec_tmout, hw_buckets_hit, slow_rejected, hw_req_id;
+  u64 queue_cycle, skipped_inputs, skipped_clones, skipped_hangs, cache_hits;
+  u64 filter_runs, filter_finds, filter_skipped, filter_explored;
+  u64 execs, crashes, hangs;          /* For the status screen            */
+  u64 replay_end;                     /* Length of the replay log         */
+  u64 corpus_data_end, corpus_index_end;  /* ... and of the packed corpus */
+};
+
+struct ckpt_entry {
+  u32 name_len, len;
+  u32 exec_cksum, cksum;              /* cksum: hash32() of the contents  */
+  u64 behavior, exec_us, handicap, depth;
+  u8  cal_failed, trim_done, was_fuzzed, passed_det, has_new_cov,
+      var_behavior, has_trace, reserved;
+};
+
+struct ckpt_req {
+  u32 name_len, len;
+  struct case_origin origin;
+  double feat[FILTER_FEATURES];
+};
+
+/* A find made after the checkpoint, to be run again on resume. */
+
+struct lost_find {
+  std::string name;                   /* File name, without the dir       */
+  std::string content;
+  u32 flags;                          /* CORPUS_*                         */
+};
+
+static int fuzz_iter = 1;             /* Next fuzzing iteration           */
+static size_t fuzz_cur;               /* Next queue entry to fuzz         */
+static u64 last_ckpt;                 /* Last checkpoint (ms)             */
+static struct ckpt_hdr resume_hdr;    /* The checkpoint we resumed from   */
+static std::vector<struct lost_find> lost_finds;
+static std::vector<struct ckpt_req> resume_reqs;  /* In flight back then  */
+static std::vector<std::string> resume_req_data;  /* ... name, contents   */
+
+static inline void ckpt_put(std::string &b, const void* mem, size_t len) {
+  b.append((const char*)mem, len);
+}
+
+static u64 ckpt_config() {
+
+  return cache_config() ^ ((u64)num_variants << 32) ^ (binary_inputs << 1) ^
+         packed_corpus;
+
+}
+
+static void save_state() {
+
+  struct ckpt_hdr h;
+  std::string b;
+  struct stat st;
+
+  memset(&h, 0, sizeof(h));
+  h.magic = CKPT_MAGIC;
+  h.version = CKPT_VERSION;
+  h.config = ckpt_config();
+  h.taken = get_cur_time();
+  h.rng_seed = rng_seed;
+  memcpy(h.rng_worker, rng_worker, sizeof(h.rng_worker));
+  h.seed_cnt = seed_cnt;
+  h.entries = input_queue.size();
+  h.elites = hw_elites.size();
+  h.behaviors = seen_behavior.size();
+  h.inputs = seen_inputs.size();
+  h.requests = hw_inflight.size();
+  h.num_variants = num_variants;
+  h.iter = fuzz_iter;
+  h.cur = fuzz_cur;
+  h.exec_tmout = exec_tmout;
+  h.hw_buckets_hit = hw_buckets_hit;
+  h.slow_rejected = slow_rejected;
+  h.hw_req_id = hw_req_id;
+  h.queue_cycle = queue_cycle;
+  h.skipped_inputs = skipped_inputs;
+  h.skipped_clones = skipped_clones;
+  h.skipped_hangs = skipped_hangs;
+  h.cache_hits = cache_hits;
+  h.filter_runs = filter_runs;
+  h.filter_finds = filter_finds;
+  h.filter_skipped = filter_skipped;
+  h.filter_explored = filter_explored;
+  h.execs = telem_execs.load(std::memory_order_relaxed);
+  h.crashes = telem_crashes.load(std::memory_order_relaxed);
+  h.hangs = telem_hangs.load(std::memory_order_relaxed);
+  if (replay_fd >= 0) h.replay_end = lseek(replay_fd, 0, SEEK_CUR);
+  if (corpus_index_fd >= 0 && !fstat(corpus_index_fd, &st)) {
+    h.corpus_data_end = corpus_end;
+    h.corpus_index_end = st.st_size;
+  }
 
-  u32 ck1 = hash32(trace_bits, MAP_SIZE, HASH_CONST);
-  SAYF("check sum of changed bitmap %u\n", ck1);
+  ckpt_put(b, &h, sizeof(h));
+  ckpt_put(b, virgin_bits, MAP_SIZE);
+  ckpt_put(b, virgin_tmout, MAP_SIZE);
+  ckpt_put(b, hw_virgin, sizeof(hw_virgin));
+  ckpt_put(b, host_arms, sizeof(host_arms));
+  ckpt_put(b, dev_arms, sizeof(dev_arms));
+  ckpt_put(b, var_arms, sizeof(var_arms));
+  ckpt_put(b, filter_w, sizeof(filter_w));
+
+  for (auto &e : hw_elites) {
+    ckpt_put(b, &e.first, 8);
+    ckpt_put(b, &e.second, sizeof(e.second));
+  }
 
-//  q->exec_cksum = ck1;
+  for (auto &e : seen_behavior) {
+    ckpt_put(b, &e.first, 8);
+    ckpt_put(b, &e.second, 4);
+  }
 
-  if (!WIFSTOPPED(status)) child_pid = 0;
+  for (auto k : seen_inputs) ckpt_put(b, &k, 8);
+
+  for (auto q : input_queue) {
+
+    struct ckpt_entry e;
+
+    memset(&e, 0, sizeof(e));
+    e.name_len = strlen(q->fname);
+    e.len = q->len;
+    e.exec_cksum = q->exec_cksum;
+    e.cksum = hash32(q->mem, q->len, HASH_CONST);
+    e.behavior = q->behavior;
+    e.exec_us = q->exec_us;
+    e.handicap = q->handicap;
+    e.depth = q->depth;
+    e.cal_failed = q->cal_failed;
+    e.trim_done = q->trim_done;
+    e.was_fuzzed = q->was_fuzzed;
+    e.passed_det = q->passed_det;
+    e.has_new_cov = q->has_new_cov;
+    e.var_behavior = q->var_behavior;
+    e.has_trace = q->trace_mini != NULL;
+
+    ckpt_put(b, &e, sizeof(e));
+    ckpt_put(b, q->fname, e.name_len);
+    ckpt_put(b, q->mem, q->len);
+    if (e.has_trace) ckpt_put(b, q->trace_mini, MAP_SIZE >> 3);
 
-  if (WIFEXITED(status))
-  {
-    printf("child exited normal exit status= %d\n", WEXITSTATUS(status));
-    return FAULT_NONE;
   }
-  else if (WIFSIGNALED(status)){
-    printf("child exited abnormal signal number= %d \n", WTERMSIG(status));
-    return FAULT_CRASH;
+
+  for (auto r : hw_inflight) {
+
+    struct ckpt_req c;
+
+    memset(&c, 0, sizeof(c));
+    c.name_len = r->input.size();
+    c.len = r->content.size();
+    c.origin = r->origin;
+    memcpy(c.feat, r->feat, sizeof(c.feat));
+
+    ckpt_put(b, &c, sizeof(c));
+    ckpt_put(b, r->input.data(), c.name_len);
+    ckpt_put(b, r->content.data(), c.len);
+
   }
-  //else if (WIFSTOPPED(status)){
-  //   printf("child stoped signal number=%d\n", WSTOPSIG(status));
-  //   return FAULT_ERROR;
-  //}
-  else if (tb4 == EXEC_FAIL_SIG){
-    return FAULT_ERROR;
+
+  std::string fn = std::string(out_dir) + CKPT_FILE, tmp = fn + ".tmp";
+  s32 fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  if (fd < 0 || write(fd, b.data(), b.size()) != (ssize_t)b.size() ||
+      fsync(fd) || close(fd) || rename(tmp.c_str(), fn.c_str())) {
+    WARNF("Unable to write the checkpoint '%s'", fn.c_str());
+    if (fd >= 0) close(fd);
+    unlink(tmp.c_str());
+    return;
   }
 
-  //if (devcloud_gpu_enable) {
-  //  devcloud_gpu_exec(app,argv);
-  //}
+  last_ckpt = get_cur_time();
+  DEBUGF("checkpoint: %u entries, %zu bytes\n", h.entries, b.size());
 
-  //if (devcloud_fpga_enable) {
-  //  devcloud_fpga_exec(app,argv);
-  //}
+}
+
+/* Reads of the mapped checkpoint; a short file is a bad one. */
+
+struct ckpt_reader {
+  const u8 *ptr, *end;
+};
+
+static void ckpt_get(struct ckpt_reader* r, void* mem, size_t len) {
+
+  if ((size_t)(r->end - r->ptr) < len) FATAL("The checkpoint is truncated");
+  memcpy(mem, r->ptr, len);
+  r->ptr += len;
 
-       
 }
-int check_execution_divergent();
 
-bool larger(std::string current, int max){
-  if(max > atoi(current.c_str())){
-    return false;
+static std::string ckpt_get_str(struct ckpt_reader* r, size_t len) {
+
+  if ((size_t)(r->end - r->ptr) < len) FATAL("The checkpoint is truncated");
+  std::string ret((const char*)r->ptr, len);
+  r->ptr += len;
+  return ret;
+
+}
+
+/* The finds of the campaign that came after the checkpoint: records past
+   its end in the packed corpus, newer files otherwise. */
+
+static void collect_lost_finds() {
+
+  struct corpus_map c;
+
+  if (packed_corpus) {
+
+    if (!map_corpus(out_dir, &c)) return;
+
+    for (u64 i = (resume_hdr.corpus_index_end - 8) / sizeof(struct corpus_rec);
+         resume_hdr.corpus_index_end >= 8 && i < c.n; i++) {
+      const struct corpus_rec &r = c.recs[i];
+      lost_finds.push_back({corpus_name(r),
+                            std::string((const char*)c.data + r.offset, r.len),
+                            r.flags});
+    }
+
+    unmap_corpus(&c);
+    return;
+
   }
-  else{
-    max = atoi(current.c_str());
-    return true;
+
+  struct dirent* ent;
+  DIR* d = opendir(out_dir);
+
+  if (!d) return;
+
+  while ((ent = readdir(d))) {
+
+    std::string name = ent->d_name, fn = std::string(out_dir) + name;
+    struct stat st;
+    size_t us = name.rfind('_');
+
+    if (name[0] == '.' || us == std::string::npos) continue;
+
+    std::string suffix = name.substr(us);
+
+    if (suffix != "_cov" && suffix != "_hd" && suffix != "_both") continue;
+    if (stat(fn.c_str(), &st)) continue;
+
+    u64 mtime = st.st_mtim.tv_sec * 1000ULL + st.st_mtim.tv_nsec / 1000000;
+    if (mtime < resume_hdr.taken) continue;
+
+    std::ifstream ifs(fn, std::ios::binary);
+    std::string content( (std::istreambuf_iterator<char>(ifs) ),
+                         (std::istreambuf_iterator<char>()    ) );
+    lost_finds.push_back({name, content, CORPUS_COV});
+
   }
+
+  closedir(d);
+
 }
 
-bool smaller(std::string current, int min){
-  if(min < atoi(current.c_str())){
-    return false;
+/* -resume: map out_dir/fuzzer_state back. The seeds are already in the
+   queue and must be the ones the checkpoint was made with. Returns false
+   if there is no checkpoint. */
+
+static bool load_state() {
+
+  std::string fn = std::string(out_dir) + CKPT_FILE;
+  size_t len;
+  const u8* mem = map_output(fn, &len);
+  struct ckpt_reader r = {mem, mem + len};
+  struct ckpt_hdr &h = resume_hdr;
+
+  if (!mem || len < sizeof(h)) return false;
+
+  ckpt_get(&r, &h, sizeof(h));
+
+  if (h.magic != CKPT_MAGIC || h.version != CKPT_VERSION)
+    FATAL("'%s' is not a checkpoint of this version", fn.c_str());
+
+  if (h.config != ckpt_config())
+    FATAL("The checkpoint was made with another target or other settings");
+
+  if (h.seed_cnt != seed_cnt || h.entries < seed_cnt)
+    FATAL("The checkpoint was made with %u seeds, '%s' has %u", h.seed_cnt,
+          in_dir, seed_cnt);
+
+  rng_seed = h.rng_seed;
+  memcpy(rng_worker, h.rng_worker, sizeof(rng_worker));
+  fuzz_iter = h.iter;
+  fuzz_cur = h.cur;
+  if (!tmout_given) exec_tmout = h.exec_tmout;
+  hw_buckets_hit = h.hw_buckets_hit;
+  slow_rejected = h.slow_rejected;
+  hw_req_id = h.hw_req_id;
+  queue_cycle = h.queue_cycle;
+  skipped_inputs = h.skipped_inputs;
+  skipped_clones = h.skipped_clones;
+  skipped_hangs = h.skipped_hangs;
+  cache_hits = h.cache_hits;
+  filter_runs = h.filter_runs;
+  filter_finds = h.filter_finds;
+  filter_skipped = h.filter_skipped;
+  filter_explored = h.filter_explored;
+  telem_execs.store(h.execs, std::memory_order_relaxed);
+  telem_crashes.store((u32)h.crashes, std::memory_order_relaxed);
+  telem_hangs.store((u32)h.hangs, std::memory_order_relaxed);
+
+  ckpt_get(&r, virgin_bits, MAP_SIZE);
+  ckpt_get(&r, virgin_tmout, MAP_SIZE);
+  ckpt_get(&r, hw_virgin, sizeof(hw_virgin));
+  ckpt_get(&r, host_arms, sizeof(host_arms));
+  ckpt_get(&r, dev_arms, sizeof(dev_arms));
+  ckpt_get(&r, var_arms, sizeof(var_arms));
+  ckpt_get(&r, filter_w, sizeof(filter_w));
+
+  for (u32 i = 0; i < h.elites; i++) {
+    u64 cell;
+    struct hw_elite e;
+    ckpt_get(&r, &cell, 8);
+    ckpt_get(&r, &e, sizeof(e));
+    hw_elites[cell] = e;
   }
-  else{
-    min = atoi(current.c_str());
-    return true;
+
+  for (u32 i = 0; i < h.behaviors; i++) {
+    u64 key;
+    u32 clones;
+    ckpt_get(&r, &key, 8);
+    ckpt_get(&r, &clones, 4);
+    seen_behavior[key] = clones;
   }
-}
 
-int check_new_hardware(){
-  int ret_val;
-  if(hardware_enabled){
-    std::ifstream ifs("hls_report/solution1/*.rpt");
-    std::string content( (std::istreambuf_iterator<char>(ifs) ),
-                       (std::istreambuf_iterator<char>()    ) );
-    if(larger(content, current_max)){
-      ret_val = 1;
-    }else ret_val = 0;
-  }else{
-    ret_val = 0;
+  seen_inputs.reserve(h.inputs);
+
+  for (u64 i = 0; i < h.inputs; i++) {
+    u64 key;
+    ckpt_get(&r, &key, 8);
+    seen_inputs.insert(key);
   }
-  if (devcloud_gpu_enable)
-  {
-    std::ifstream inFile;
-    inFile.open("exec_info.txt");
-    double gflops=406;
-    if (!inFile.is_open()){
-            std::cout<<"can't open exec_info file\n";
-    }
-    inFile >> gflops;
-    inFile.close();
-    printf("GFLOPS MAX%lf\n",GFLOPS_max);
-    printf("GFLOPS MIN%lf\n",GFLOPS_min);
-    printf("gpu enabled with gflops:%lf\n",&gflops);
-    if(gflops>GFLOPS_max){
-      GFLOPS_max = gflops;
-      printf("GFLOPS MAX%lf\n",GFLOPS_max);
-      ret_val = 1;
-    }
-    else if (gflops<GFLOPS_min){
-      GFLOPS_min = gflops;
-      printf("GFLOPS MIN%lf\n",GFLOPS_min);
-      ret_val = 1;
+
+  for (u32 i = 0; i < h.entries; i++) {
+
+    struct ckpt_entry e;
+    struct queue_entry* q;
+
+    ckpt_get(&r, &e, sizeof(e));
+    std::string name = ckpt_get_str(&r, e.name_len);
+    std::string content = ckpt_get_str(&r, e.len);
+
+    if (i < seed_cnt) {
+      q = input_queue[i];
+      if (q->len != e.len || hash32(q->mem, q->len, HASH_CONST) != e.cksum)
+        FATAL("Seed '%s' is not the one the checkpoint was made with", q->fname);
+    } else {
+      q = add_to_queue(name, content);
     }
-    else {
-      ret_val=0;
+
+    q->exec_cksum = e.exec_cksum;
+    q->behavior = e.behavior;
+    q->exec_us = e.exec_us;
+    q->handicap = e.handicap;
+    q->depth = e.depth;
+    q->cal_failed = e.cal_failed;
+    q->trim_done = e.trim_done;
+    q->was_fuzzed = e.was_fuzzed;
+    q->passed_det = e.passed_det;
+    q->has_new_cov = e.has_new_cov;
+    q->var_behavior = e.var_behavior;
+
+    /* top_rated and the totals are rebuilt from the trace, the same way
+       the entry got them. */
+
+    if (e.has_trace) {
+
+      u8 mini[MAP_SIZE >> 3];
+
+      ckpt_get(&r, mini, sizeof(mini));
+      for (u32 j = 0; j < MAP_SIZE; j++)
+        trace_bits[j] = (mini[j >> 3] >> (j & 7)) & 1;
+      update_bitmap_score(q);
+
     }
 
   }
 
-  if (devcloud_fpga_hd_enable or devcloud_fpga_enable){
-    std::ifstream inFile;
-    inFile.open("exec_fpga_info.txt");
-    if (!inFile.is_open()){
-            std::cout<<"can't open exec_info file\n";
-    }
-    double exec_time = 0;
-    double DSPs = 0;
-    double FMax = 0;
-    inFile >> exec_time >> DSPs >> FMax;
-    inFile.close();
-    printf("fpga execution time:%lf\n",exec_time);
-    if(exec_time>time_max){
-      time_max = exec_time;
-      printf("TIME MAX%lf\n",time);
-      ret_val = 1;
+  memset(trace_bits, 0, MAP_SIZE);
+  score_changed = 1;
+
+  for (u32 i = 0; i < h.requests; i++) {
+    struct ckpt_req c;
+    ckpt_get(&r, &c, sizeof(c));
+    resume_reqs.push_back(c);
+    resume_req_data.push_back(ckpt_get_str(&r, c.name_len));
+    resume_req_data.push_back(ckpt_get_str(&r, c.len));
+  }
+
+  munmap((void*)mem, len);
+
+  u32 cov = 0;
+  for (u32 i = 0; i < MAP_SIZE; i++) cov += virgin_bits[i] != 0xff;
+  telem_cov.store(cov, std::memory_order_relaxed);
+
+  collect_lost_finds();
+
+  /* Iterations name the files; the lost finds' names are taken. */
+
+  for (auto &f : lost_finds)
+    if (isdigit(f.name[0])) fuzz_iter = MAX(fuzz_iter, atoi(f.name.c_str()) + 1);
+
+  OKF("Resumed from a checkpoint of %llu s ago: iteration %d, %u entries, "
+      "%u hardware buckets (random seed %llu).", (get_cur_time() - h.taken) / 1000,
+      fuzz_iter, h.entries, hw_buckets_hit, rng_seed);
+
+  return true;
+
+}
+
+/* After load_state(), once the target is up: run the finds the checkpoint
+   missed again, keep the crashes and hangs among them, and submit the
+   devcloud inputs that were in flight again. */
+
+static void import_lost_finds(char* app) {
+
+  u32 imported = 0;
+
+  resume_import = 1;
+
+  for (auto &f : lost_finds) {
+
+    if (f.flags & (CORPUS_CRASH | CORPUS_HANG)) {
+      if (packed_corpus)
+        store_test_case(std::string(out_dir) + f.name, f.content, f.flags, NULL);
+      continue;
     }
 
-    if (DSPs>DSP_max){
-      DSP_max = DSPs;
-      printf("DSPs MAX%lf\n",DSP_max);
-      ret_val = 1;
+    /* Under its old name, without the suffix write_to_test() adds. */
+
+    std::string fname = std::string(out_dir) + f.name.substr(0, f.name.rfind('_'));
+    common_fuzz_stuff(app, fname, f.content);
+    imported++;
+
+  }
+
+  resume_import = 0;
+
+  for (u32 i = 0; i < resume_reqs.size() && devcloud_jobs(); i++) {
+    cur_case = resume_reqs[i].origin;
+    memcpy(cur_feat, resume_reqs[i].feat, sizeof(cur_feat));
+    hw_dispatch(app, resume_req_data[2 * i], resume_req_data[2 * i + 1]);
+  }
+
+  cur_case = no_case;
+
+  if (imported || !resume_reqs.empty())
+    OKF("Ran %u finds newer than the checkpoint again, resubmitted %u devcloud "
+        "inputs.", imported, (u32)resume_reqs.size());
+
+  lost_finds.clear();
+  resume_reqs.clear();
+  resume_req_data.clear();
+
+}
+
+/* Totals for the telemetry thread. */
+
+static void telem_publish() {
+
+  telem_queue.store(input_queue.size(), std::memory_order_relaxed);
+  telem_favored.store(queued_favored, std::memory_order_relaxed);
+  telem_cycles.store(queue_cycle, std::memory_order_relaxed);
+  telem_hw_buckets.store(hw_buckets_hit, std::memory_order_relaxed);
+
+}
+
+/* Main loop: walk the queue in cycles, skip most entries that are not
+   favored and give each entry its energy's worth of mutations. iteration
+   bounds the number of executions. */
+
+void fuzzing(char* app, int iteration){
+
+  size_t &cur = fuzz_cur;
+  int &i = fuzz_iter;
+
+  if (input_queue.size()==0){
+    load_queue(out_dir); //TODO: change to input dir of target app 
+  }
+
+  last_ckpt = get_cur_time();
+
+  while (i < iteration && !stop_soon) {
+
+    if (cur >= input_queue.size()) {
+      cur = 0;
+      queue_cycle++;
+      DEBUGF("queue cycle %llu: %u entries, %u favored\n", queue_cycle,
+             (u32)input_queue.size(), queued_favored);
     }
-    if (DSPs<DSP_min){
-      DSP_min = DSPs;
-      printf("DSPs MIN%lf\n",DSP_min);
-      ret_val = 1;
+
+    cull_queue();
+
+    struct queue_entry* q = input_queue[cur++];
+
+    /* Like AFL: while favored entries are waiting, nearly everything
+       else is skipped; otherwise non-favored entries still get an
+       occasional turn, new ones more often. */
+
+    if (pending_favored) {
+      if ((q->was_fuzzed || !q->favored) &&
+          rng_next(rng_worker) % 100 < SKIP_TO_NEW_PROB) continue;
+    } else if (!q->favored && input_queue.size() > 10) {
+      if (queue_cycle > 1 && !q->was_fuzzed) {
+        if (rng_next(rng_worker) % 100 < SKIP_NFAV_NEW_PROB) continue;
+      } else {
+        if (rng_next(rng_worker) % 100 < SKIP_NFAV_OLD_PROB) continue;
+      }
     }
 
-    if (FMax>fmax_max){
-      fmax_max = FMax;
-      printf("FMax MAX%lf\n",FMax);
-      ret_val = 1;
+    u32 perf_score = calculate_score(q);
+    u32 energy = perf_score * SCHED_EXECS / 100;
+    if (!energy) energy = 1;
+
+    DEBUGF("mutating: %s (perf score %u, %u runs)\n", q->fname, perf_score,
+           energy);
+
+    for (u32 e = 0; e < energy && i < iteration && !stop_soon; e++, i++) {
+
+      DEBUGF("\n**********%d**********\n", i);
+
+      if (get_cur_time() - last_ckpt >= CKPT_INTERVAL) save_state();
+
+      if (sync_id && !(i % SYNC_ITERATIONS)) sync_fuzzers(app);
+
+      cur_case.id = i;
+      cur_case.parent = cur - 1;
+      cur_case.seed = rng_next(rng_worker);
+      cur_case.depth = q->depth;
+      cur_case.host_arm = pick_arm(host_arms, HOST_ARMS);
+      cur_case.dev_arm = pick_arm(dev_arms, DEV_ARMS);
+      cur_case.var_arm = num_variants ? pick_arm(var_arms, num_variants) : -1;
+
+      rng_init(rng_mut, cur_case.seed);
+      u64 start_us = get_cur_time_us();
+      std::string content = mutate(q, cur_case.host_arm + 1);
+      telem_record(STAGE_MUTATE, get_cur_time_us() - start_us);
+
+      common_fuzz_stuff(app, std::string(out_dir) + std::to_string(i), content);
+      telem_publish();
+
+      cur_case = no_case;
+
     }
-    if (FMax<fmax_min){
-      fmax_min = FMax;
-      printf("FMax MIN%lf\n",FMax);
-      ret_val = 1;
+
+    if (!q->was_fuzzed) {
+      q->was_fuzzed = 1;
+      if (q->favored && pending_favored) pending_favored--;
     }
+
   }
-  if (check_execution_divergent()==1) return 1;
-  return ret_val;
+
+  /* Stopped by a signal: what is in flight goes into the checkpoint
+     instead of holding up the exit. */
+
+  if (!stop_soon) hw_drain();
+  telem_publish();
 }
 
-bool verify_result(std::string output, std::string res){
-  printf("%s", "check results across different platform...");
-  std::ifstream ifs(output);
-  std::string content( (std::istreambuf_iterator<char>(ifs) ),
-                       (std::istreambuf_iterator<char>()    ) );
-  std::ifstream ans(res);
-  std::string answer( (std::istreambuf_iterator<char>(ans) ),
-                       (std::istreambuf_iterator<char>()    ) );
 
-  if (answer.compare(res)==0){
-    return true;
+/* Dry run: run every seed once, to check that the target works and to
+   start the campaign from what the seeds cover. The seeds don't depend on
+   each other, so up to dry_jobs() of them run at the same time, each with
+   its own trace map, metrics record and input file, and are merged in the
+   order they finish. A seed that crashes is reported and kept; one that
+   times out (or a target that does not exec) stops the campaign. */
+
+#define DRY_MAX_JOBS 16               /* Seeds run at the same time       */
+
+struct dry_slot {
+  s32 shm_id, metrics_id;             /* Its own shm segments             */
+  u8* trace;                          /* ... attached                     */
+  struct hfuzz_metrics* m;
+  s32 fd;                             /* Input file                       */
+  std::string path;                   /* ... as a path for the target     */
+  pid_t pid;                          /* Running seed, 0 if idle          */
+  u32 seed;                           /* ... its queue index              */
+  u64 start_us;                       /* ... when it started              */
+  bool timed_out;
+};
+
+static std::vector<s32> dry_shm_ids;  /* For remove_shm()                 */
+
+/* One per CPU we may run on; with -b, or in a pinned job, that is one. */
+
+static u32 dry_jobs() {
+
+  cpu_set_t c;
+  u32 n = 1;
+
+  if (!sched_getaffinity(0, sizeof(c), &c)) n = CPU_COUNT(&c);
+
+  return MAX(MIN(n, (u32)DRY_MAX_JOBS), 1u);
+
+}
+
+static void setup_dry_slot(struct dry_slot* s, u32 id) {
+
+  s->shm_id = shmget(IPC_PRIVATE, MAP_SIZE, IPC_CREAT | IPC_EXCL | 0600);
+  s->metrics_id = shmget(IPC_PRIVATE, sizeof(struct hfuzz_metrics),
+                         IPC_CREAT | IPC_EXCL | 0600);
+
+  if (s->shm_id < 0 || s->metrics_id < 0) PFATAL("Failed to creat a shared memory");
+
+  dry_shm_ids.push_back(s->shm_id);
+  dry_shm_ids.push_back(s->metrics_id);
+
+  s->trace = (u8*)shmat(s->shm_id, NULL, 0);
+  s->m = (struct hfuzz_metrics*)shmat(s->metrics_id, NULL, 0);
+
+  if (s->trace == (void*)-1 || s->m == (void*)-1) PFATAL("shmat() failed");
+
+  s->fd = -1;
+
+#ifdef MFD_CLOEXEC
+
+  s->fd = memfd_create("hfuzz-dry-input", 0);
+  if (s->fd >= 0) s->path = "/dev/fd/" + std::to_string(s->fd);
+
+#endif /* MFD_CLOEXEC */
+
+  if (s->fd < 0) {
+    s->path = std::string(out_dir) + ".dry_input." + std::to_string(id);
+    s->fd = open(s->path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (s->fd < 0) PFATAL("Unable to create '%s'", s->path.c_str());
   }
-  printf("%s", "divergent results across different platform!");
-  return false;
+
+  s->pid = 0;
+
+}
+
+static void start_dry_seed(struct dry_slot* s, u32 seed, char* bin) {
+
+  struct queue_entry* q = input_queue[seed];
+
+  memset(s->trace, 0, MAP_SIZE);
+  memset(s->m, 0, sizeof(*s->m));
+
+  if (ftruncate(s->fd, 0) || pwrite(s->fd, q->mem, q->len, 0) != (ssize_t)q->len)
+    PFATAL("Short write to '%s'", s->path.c_str());
+
+  s->seed = seed;
+  s->timed_out = 0;
+  s->start_us = get_cur_time_us();
+  s->pid = fork();
+
+  if (s->pid < 0) PFATAL("fork() failed");
+
+  if (!s->pid) {
+
+    char* argv[] = {bin, (char*)s->path.c_str(), NULL};
+
+    setpgid(0, 0);
+    setenv(SHM_ENV_VAR, std::to_string(s->shm_id).c_str(), 1);
+    setenv(METRICS_ENV_VAR, std::to_string(s->metrics_id).c_str(), 1);
+    execv(bin, argv);
+    *(u32*)s->trace = EXEC_FAIL_SIG;
+    exit(0);
+
+  }
+
+}
+
+/* Merge the result of the seed that ran in s, the way a run found by
+   fuzzing would be. */
+
+static void finish_dry_seed(struct dry_slot* s, int status, char* bin) {
+
+  struct queue_entry* q = input_queue[s->seed];
+  struct hfuzz_metrics m;
+  s32 feat[HW_FEATURES];
+
+  s->pid = 0;
+
+  if (s->timed_out)
+    FATAL("Seed '%s' timed out after %u ms (raise it with -t)", q->fname,
+          exec_tmout);
+
+  if (*(u32*)s->trace == EXEC_FAIL_SIG) FATAL("Unable to execute '%s'", bin);
+
+  if (WIFSIGNALED(status))
+    WARNF("Seed '%s' crashed with signal %d", q->fname, WTERMSIG(status));
+
+  memcpy(trace_bits, s->trace, MAP_SIZE);
+  classify_counts((u64*)trace_bits);
+
+  /* Its metrics, as load_metrics() would have them from the shared
+     record; the seeds' buckets and cells are the baseline, like their
+     coverage. */
+
+  memcpy(&m, s->m, sizeof(m));
+  if (m.magic != METRICS_MAGIC) load_legacy_metrics("", &m);
+
+  last_metrics = m;
+  cur_hw_key = hw_metrics_key(&m);
+
+  hw_features(&m, feat);
+  has_new_hw_buckets(feat);
+  update_hw_elites(&m, feat);
+
+  q->exec_cksum = hash32(trace_bits, MAP_SIZE, HASH_CONST);
+  q->has_new_cov = 1;
+  q->behavior = behavior_key();
+  q->exec_us = get_cur_time_us() - s->start_us;
+  seen_behavior[q->behavior] = 0;
+  update_bitmap_score(q);
+  score_changed = 1;
+
+  // the seeds' coverage is the baseline
+  has_new_bits(virgin_bits);
+
+  DEBUGF("seed %s: checksum %u, %llu us\n", q->fname, q->exec_cksum, q->exec_us);
+
 }
 
-int check_execution_divergent(){
-  int ret_val;
-  if (!verify_result("gpu.txt","fpga_simulation.txt")) return 1;
-  //if (!verify_result("gpu.txt","fpga.txt")) return 1;
-  return 0;
-}
+void perform_dry_run(char* app){
+
+  u32 jobs = MIN(dry_jobs(), (u32)input_queue.size()), next = 0, running = 0;
+  std::vector<struct dry_slot> slots(jobs);
+  u64 start_ms = get_cur_time();
+
+  ACTF("Attempting dry run with '%s' (%u seeds, %u at a time)...", app,
+       (u32)input_queue.size(), jobs);
+
+  /* With -D, app only names the backend builds. */
+
+  char* bin = backends.empty() ? app : (char*)backends[0].bin.c_str();
 
-int check_performance_divergent(){
-    int ret_val;
-    if (hardware_enabled){
-        std::ifstream ifs("hls_report/solution1/*.rpt");
-        
+  for (u32 i = 0; i < jobs; i++) setup_dry_slot(&slots[i], i);
+
+  while (next < input_queue.size() || running) {
+
+    for (auto &s : slots) {
+      if (s.pid || next >= input_queue.size()) continue;
+      start_dry_seed(&s, next++, bin);
+      running++;
     }
-    return ret_val;
-}
 
-// change the probability based on update rule
-void update_probability(){
-      std::vector<int> prob_int;
-    int sum = 0;
-    for(int i=0;i<prob.size();i++) {
-        if(mut[i]){
-          prob[i] = prob[i] + 0.05;
-        }
-        else
-        {
-          prob[i] = prob[i] - 0.05/(mut.size()-1);
+    int status;
+    pid_t pid = waitpid(-1, &status, WNOHANG);
+
+    if (pid < 0 && errno != EINTR) PFATAL("waitpid() failed");
+
+    if (pid > 0) {
+      for (auto &s : slots)
+        if (s.pid == pid) {
+          finish_dry_seed(&s, status, bin);
+          running--;
         }
-        
-        prob_int.push_back(sum);
+      continue;
     }
-}
 
-/*save the input if a new edge is covered or maximize a hardware divergence character
-return 0 if not interested, return 1 if new coverage, return 2 if new hardware character,
-return 3 if both;
-*/
+    /* Nothing finished: kill the seeds that are over time, and look
+       again in a bit. */
 
-int save_if_interest(){
-  int ret_val = 0;
-  int new_coverage = 0;
-  int new_hardware = 0;
+    u64 now = get_cur_time_us();
+
+    for (auto &s : slots)
+      if (s.pid && !s.timed_out && now - s.start_us > exec_tmout * 1000ULL) {
+        s.timed_out = 1;
+        kill_group(s.pid);
+      }
+
+    usleep(500);
 
-  for(int i = 0; i < (1<<16); ++i) {
-    if(trace_bits[i] && !total_bits[i]) {
-      total_bits[i] = 1;
-      new_coverage = 1;
-    }
   }
 
-  new_hardware = check_new_hardware();
-  
-  if(new_coverage && new_hardware){
-    update_probability();
-    return NEW_BOTH;
-  }else if(new_coverage && !new_hardware){
-    return NEW_COVERAGE;
-  }else if(!new_coverage && new_hardware){
-    update_probability();
-    return NEW_HARDWARE;
+  for (auto &s : slots) {
+    shmdt(s.trace);
+    shmdt(s.m);
+    shmctl(s.shm_id, IPC_RMID, NULL);
+    shmctl(s.metrics_id, IPC_RMID, NULL);
+    close(s.fd);
+    if (s.path.compare(0, 8, "/dev/fd/")) unlink(s.path.c_str());
   }
 
-  return NOT_INTEREST;
-}
+  dry_shm_ids.clear();
 
-void write_to_test(std::string current_input, int interest){
-  
-  if(!interest) remove(current_input.c_str());
-  else{
-    struct queue_entry *q = (struct queue_entry *)malloc(sizeof(queue_entry));
-    q->exec_cksum = hash32(trace_bits, MAP_SIZE, HASH_CONST);
+  OKF("Dry run: %u seeds in %llu ms.", (u32)input_queue.size(),
+      get_cur_time() - start_ms);
 
-    std::string new_name; 
-    if(interest == NEW_COVERAGE){
-      q->has_new_cov = 1;
-      new_name = std::string(current_input) + "_cov";
-    }
-    else if(interest == NEW_HARDWARE) new_name = std::string(current_input) + "_hd";
-    else if(interest == NEW_BOTH){
-      q->has_new_cov = 1;
-      new_name = std::string(current_input) + "_both";
-    }
-    rename(current_input.c_str(), new_name.c_str());
-    memcpy(q->fname, new_name.c_str(), 256);
-    input_queue.push_back(q);
-  }
-  
 }
 
-void write_to_test(std::string current_input){
-  std::string new_name = std::string(current_input) + "_crash";
-  rename(current_input.c_str(), new_name.c_str());
-}
+/* -r: rebuild a test case of an earlier run from the seeds and the replay
+   log, replaying the mutations on the way from its seed. */
 
-std::vector<std::string> SplitString(std::string &s, const std::string &delimiter) {
-	size_t pos = 0;
-	std::string token;
-	std::vector<std::string> ret;
-	while ((pos = s.find(delimiter)) != std::string::npos) {
-		token = s.substr(0, pos);
-		//std::cout << token << std::endl;
-		ret.push_back(token);
-		s.erase(0, pos + delimiter.length());
-	}
-	ret.push_back(s);
-	return ret;
-}
+static std::vector<struct replay_rec> replay_recs;
+static s64 replay_id = -1;            /* -r                               */
 
-/*Selective invocation based on the boundaries of input values*/
+static bool replay_case(const struct replay_rec &r, std::string &out);
 
-bool worthy_simulation(std::string input){
-  if(hardware_enabled){
-    	std::vector<std::string> input_list = SplitString(input,"/n");
-			for(auto arg:input_list) {
-				if(atoi(arg.c_str()) > input_max) return true;
-        else if(atoi(arg.c_str()) < input_min) return true;
-        else return false;
-			}
-  }else{
+static bool replay_entry(u32 queue_id, std::string &out) {
+
+  if (queue_id < seed_cnt) {
+    out.assign((char*)input_queue[queue_id]->mem, input_queue[queue_id]->len);
     return true;
   }
+
+  for (auto &r : replay_recs)
+    if (r.queue_id == queue_id && r.kind == REPLAY_MUTATE)
+      return replay_case(r, out);
+
+  return false;
+
 }
 
-/* Fuzzing iterations: randomly select an input, mutate it, run the target
-with the mutated input, check the coverage and update input queue */
+static bool replay_case(const struct replay_rec &r, std::string &out) {
 
-void fuzzing(char* app, int iteration){
+  std::string parent;
+  struct queue_entry q;
 
-  for(int i = 1; i < iteration; i ++){
-    printf("\n**********%d**********\n", i);
+  /* Test cases synced from peers are in their own logs. */
 
-    srand(time(0) + rand());
-    if (input_queue.size()==0){
-      list_dir(out_dir); //TODO: change to input dir of target app 
-    }
-    int index = rand()%input_queue.size();
-        printf("input queue length: %d\n", input_queue.size());
-     for(int i = 0; i < input_queue.size(); i++){
-       printf("%s\n ", input_queue[i]->fname);
-     }
+  if (r.parent == NO_PARENT || !r.knob) return false;
+  if (!replay_entry(r.parent, parent)) return false;
 
-    struct queue_entry* q = input_queue[index];
-    std::string current_input = std::string(q->fname);
+  memset(&q, 0, sizeof(q));
+  q.mem = (u8*)parent.data();
+  q.len = parent.size();
 
-    std::string mutated_input = mutate(i, current_input);
-    std::cout << "running with mutated input: " << mutated_input << std::endl ;
-    char mutated[256] = "0";
-    strncpy(mutated, mutated_input.c_str(), mutated_input.length() + 1);
+  rng_init(rng_mut, r.seed);
+  out = mutate(&q, r.knob);
 
-    if(worthy_simulation(mutated_input)){
-      int crash = run_target(app, mutated);
+  delete q.typed;
 
-      if(crash){ //if found crash
-        write_to_test(mutated_input);
-      }else{  // else check the guidance
-        int interest = save_if_interest();
-        printf("the current input is interest: %d\n", interest);
-        write_to_test(mutated_input, interest);
-        }
-      }
+  /* Redo the cuts trim_case() made, on the same representation. */
 
-    while (input_queue.size()>1){
-      input_queue.pop_back();
-    }
+  std::vector<typed_value> vals;
+  bool typed = false, binary = binary_inputs || is_hfzb(out), trimmed = false;
+
+  parse_typed(out, vals);
+  typed = !vals.empty();
+
+  for (auto &t : replay_recs) {
+    if (t.kind != REPLAY_TRIM || t.queue_id != r.queue_id ||
+        r.queue_id == REPLAY_CRASH) continue;
+    apply_trim(out, vals, typed, t.parent, t.seed);
+    trimmed = true;
   }
+
+  if (trimmed && typed) out = emit_typed(vals, binary);
+
+  return true;
+
 }
 
+static void regenerate() {
 
-/* Perform dry run of all test cases to confirm that the app is working as
-   expected. This is done only for the initial inputs, and only once. */
+  std::string fn = std::string(out_dir) + REPLAY_FILE;
+  std::ifstream ifs(fn, std::ios::binary);
+  u32 hdr[4];
+  u64 seed;
+  struct replay_rec rec;
+  const struct replay_rec* found = NULL;
 
-void perform_dry_run(char* app){
-  ACTF("Attempting dry run with '%s'...", app);
+  if (!ifs.read((char*)hdr, sizeof(hdr)) || !ifs.read((char*)&seed, 8) ||
+      hdr[0] != REPLAY_MAGIC || hdr[1] != REPLAY_VERSION)
+    FATAL("'%s' is not a replay log", fn.c_str());
 
-  int status = 0;
-  memset(trace_bits, 0, MAP_SIZE);
+  if (hdr[3] != seed_cnt)
+    FATAL("The run had %u seeds, '%s' has %u", hdr[3], in_dir, seed_cnt);
 
-  //char* argv[] = {app, "/Desktop/Heterofuzz/prototype/good-seeds/anyseed", NULL};
-  char* argv[] = {app, "/Desktop/Heterofuzz/prototype/matrix-seed/anyseed", NULL};
+  binary_inputs = hdr[2] & REPLAY_BINARY;
 
-  child_pid = fork();
-  if(child_pid < 0){
-    perror("fork error.");
-    exit(EXIT_FAILURE);
-  }
-  
-  if(!child_pid){ // This is child process
-    printf("This is the child process");
-    execv(app, argv);
-    *(u32*)trace_bits = EXEC_FAIL_SIG;
-    exit(0);
-  }
+  while (ifs.read((char*)&rec, sizeof(rec))) replay_recs.push_back(rec);
 
-  pid_t ret;
-  ret = waitpid(child_pid, &status, 0);
-  if(ret < 0){
-    perror("wait error");
-    exit(EXIT_FAILURE);
-  }
-  
+  for (auto &r : replay_recs)
+    if (r.id == replay_id && r.kind == REPLAY_MUTATE) found = &r;
 
-//  int tb4 = *(u32*)trace_bits;
+  if (!found) FATAL("No test case %lld in '%s'", (long long)replay_id, fn.c_str());
 
-  u32 ck1 = hash32(trace_bits, MAP_SIZE, HASH_CONST);
-  SAYF("check sum of changed bitmap %u\n", ck1);
+  std::string content;
 
-  // FILE* f = fopen("1.dat", "w");
-  // for(int i = 0; i < MAP_SIZE; i++)
-  // {
-  //   fprintf(f, "%d ", trace_bits[i]);
-  // }
-  // fclose(f);
-  
-  //update the checksum of seed input
-  input_queue[0]->exec_cksum = ck1;
-  input_queue[0]->has_new_cov = 1;
+  if (!replay_case(*found, content))
+    FATAL("Test case %lld was synced from another worker, see its log",
+          (long long)replay_id);
 
-  // update the total coverage
-  memcpy(total_bits, trace_bits, sizeof(u8)*(1<<16));
+  std::string name = std::string(out_dir) + std::to_string(replay_id) + "_replay";
+  save_test_case(name, content);
 
-  if (!WIFSTOPPED(status)) child_pid = 0;
+  OKF("Rebuilt test case %lld as '%s' (knob %u, seed %llu).",
+      (long long)replay_id, name.c_str(), found->knob, found->seed);
 
-  if (WIFEXITED(status))
-        printf("child exited normal exit status= %d\n", WEXITSTATUS(status));
+  if (found->dev_knob)
+    OKF("Run it with " KNOB_ENV_VAR "=%u " SEED_ENV_VAR "=%llu to repeat its "
+        "device-side mutations.", found->dev_knob, found->seed);
+
+  if (found->variant)
+    OKF("It ran kernel variant " VARIANT_ENV_VAR "=%u.", found->variant);
 
-    else if (WIFSIGNALED(status))
-        printf("child exited abnormal signal number= %d \n", WTERMSIG(status));
-    else if (WIFSTOPPED(status))
-        printf("child stoped signal number=%d\n", WSTOPSIG(status));
+}
+
+/* Get rid of the shared memory segments (atexit handler). */
+
+static void remove_shm(void) {
+
+  shmctl(shm_id, IPC_RMID, NULL);
+  shmctl(metrics_shm_id, IPC_RMID, NULL);
+  for (auto id : dry_shm_ids) shmctl(id, IPC_RMID, NULL);
 
 }
 
@@ -807,7 +5374,8 @@ static void setup_shm(){
   ACTF("Setting up the shared memory for code coverage...");
   u8* shm_str;
 
-  memset(total_bits, 0, MAP_SIZE);
+  memset(virgin_bits, 255, MAP_SIZE);
+  memset(virgin_tmout, 255, MAP_SIZE);
 
   shm_id = shmget(IPC_PRIVATE, MAP_SIZE, IPC_CREAT | IPC_EXCL | 0600);
   
@@ -821,37 +5389,472 @@ static void setup_shm(){
 
 
   trace_bits = (unsigned char*)shmat(shm_id, NULL, 0);
-  if (!trace_bits) PFATAL("shmat() failed");
+  if (trace_bits == (void*)-1) PFATAL("shmat() failed");
+
+  metrics_shm_id = shmget(IPC_PRIVATE, sizeof(struct hfuzz_metrics),
+                          IPC_CREAT | IPC_EXCL | 0600);
+
+  if (metrics_shm_id < 0) PFATAL("Failed to creat a shared memory");
+
+  atexit(remove_shm);
+
+  shm_str = alloc_printf("%d", metrics_shm_id);
+  setenv(METRICS_ENV_VAR, (char*)shm_str, 1);
+  ck_free(shm_str);
+
+  metrics = (struct hfuzz_metrics*)shmat(metrics_shm_id, NULL, 0);
+  if (metrics == (void*)-1) PFATAL("shmat() failed");
 }
 
 /* Main entry point */
 //undone: first run + output file in target application + add .sh and figure out path
 
+/* Self-benchmark (-X). Times the fuzzer's own hot paths, so that a
+   change can be checked for regressions before it goes out to the
+   cluster:
+
+     exec_fork, exec_forksrv     executions of the target, which should be
+                                 benchmark/null/null_target.cpp, with
+                                 fork/execv and with the fork server
+     mutate_N                    mutate() with host knob N, on the seeds
+     merge_sparse, merge_dense   classify_counts(), has_new_bits() and the
+                                 hardware buckets of a run, on a synthetic
+                                 trace with 1% and 50% of the map hit
+     hash32                      hash32() of the whole map
+     metrics_shm, metrics_file   load_metrics() from shm and from a job dir
+
+   max_trials is the number of rounds of each. The results go to
+   out_dir/self_bench.json, one object per benchmark. */
+
+#define BENCH_FILE "self_bench.json"
+
+struct bench_result {
+  std::string name;
+  u64 ops;                            /* Rounds                           */
+  u64 ns;                             /* Total time                       */
+};
+
+static std::vector<bench_result> bench_results;
+static volatile u64 bench_sink;       /* Keeps the work from going away   */
+
+static void bench_report(const std::string &name, u64 ops, u64 ns) {
+
+  if (!ns) ns = 1;
+
+  bench_results.push_back({name, ops, ns});
+  OKF("%-14s %14.1f ops/s %12.1f ns/op", name.c_str(), ops * 1e9 / ns,
+      (double)ns / ops);
+
+}
+
+/* Synthetic trace with pct% of the bytes hit. */
+
+static void bench_map(u8* map, u32 pct) {
+
+  for (u32 i = 0; i < MAP_SIZE; i++)
+    map[i] = rng_next(rng_worker) % 100 < pct ? 1 + rng_next(rng_worker) % 255 : 0;
+
+}
+
+static void bench_save() {
+
+  std::string fn = std::string(out_dir) + BENCH_FILE;
+  char host[256] = {0};
+  FILE* f = fopen(fn.c_str(), "w");
+
+  if (!f) PFATAL("Unable to create '%s'", fn.c_str());
+
+  gethostname(host, sizeof(host) - 1);
+
+  fprintf(f, "{\n  \"version\": \"%s\",\n  \"host\": \"%s\",\n  \"time\": %llu,\n"
+             "  \"rounds\": %d,\n  \"results\": [\n", VERSION, host,
+          get_cur_time() / 1000, max_trials);
+
+  for (size_t i = 0; i < bench_results.size(); i++) {
+    struct bench_result* b = &bench_results[i];
+    fprintf(f, "    {\"name\": \"%s\", \"ops\": %llu, \"ns\": %llu, "
+               "\"ops_per_sec\": %.1f, \"ns_per_op\": %.1f}%s\n",
+            b->name.c_str(), b->ops, b->ns, b->ops * 1e9 / b->ns,
+            (double)b->ns / b->ops, i + 1 < bench_results.size() ? "," : "");
+  }
+
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+
+  OKF("Results written to '%s'.", fn.c_str());
+
+}
+
+static void self_bench(char* app) {
+
+  static u8 tmpl[MAP_SIZE];
+  u64 rounds = max_trials, start;
+  struct hfuzz_metrics m;
+
+  if (input_queue.empty()) FATAL("No seeds in '%s'", in_dir);
+  if (!rounds) FATAL("Need at least one round");
+
+  std::string content((char*)input_queue[0]->mem, input_queue[0]->len);
+
+  ACTF("Benchmarking with %llu rounds each...", rounds);
+
+  /* Executions: fork/execv, then the fork server. */
+
+  start = get_cur_time_ns();
+  for (u64 r = 0; r < rounds; r++) run_target(app, content);
+  bench_report("exec_fork", rounds, get_cur_time_ns() - start);
+
+  forkserver_mode = 1;
+  init_forkserver(app);
+
+  start = get_cur_time_ns();
+  for (u64 r = 0; r < rounds; r++) run_target(app, content);
+  bench_report("exec_forksrv", rounds, get_cur_time_ns() - start);
+
+  if (child_pid > 0) kill(child_pid, SIGKILL);
+  if (forksrv_pid > 0) kill(forksrv_pid, SIGKILL);
+  forkserver_mode = 0;
+
+  /* Mutation, per host knob. */
+
+  for (u32 k = 0; k < HOST_ARMS; k++) {
+
+    start = get_cur_time_ns();
+
+    for (u64 r = 0; r < rounds; r++) {
+      rng_init(rng_mut, r);
+      bench_sink += mutate(input_queue[r % input_queue.size()], k + 1).size();
+    }
+
+    bench_report("mutate_" + std::to_string(k + 1), rounds,
+                 get_cur_time_ns() - start);
+
+  }
+
+  /* Merging a run into the virgin map. The first round finds all of the
+     trace, the rest hit the common no-news path. The metrics record is
+     a made-up one, so that the hardware side has something to look at.
+     This is the in-memory part of save_if_interest(); the reports it
+     reads for divergence and synthesis results would be all we timed. */
+
+  memset(metrics, 0, sizeof(*metrics));
+  metrics->magic = METRICS_MAGIC;
+  metrics->flags = M_EXEC_TIME;
+  metrics->exec_time = 1;
+
+  const char* maps[] = {"merge_sparse", "merge_dense"};
+  u32 density[] = {1, 50};
+
+  for (u32 i = 0; i < 2; i++) {
+
+    u64 ns = 0;
+
+    bench_map(tmpl, density[i]);
+    memset(virgin_bits, 255, MAP_SIZE);
+
+    for (u64 r = 0; r < rounds; r++) {
+
+      s32 feat[HW_FEATURES];
+
+      memcpy(trace_bits, tmpl, MAP_SIZE);
+      start = get_cur_time_ns();
+
+      classify_counts((u64*)trace_bits);
+      bench_sink += has_new_bits(virgin_bits);
+
+      load_metrics("", &m);
+      hw_features(&m, feat);
+      bench_sink += has_new_hw_buckets(feat);
+
+      ns += get_cur_time_ns() - start;
+
+    }
+
+    bench_report(maps[i], rounds, ns);
+
+  }
+
+  start = get_cur_time_ns();
+  for (u64 r = 0; r < rounds; r++) bench_sink += hash32(trace_bits, MAP_SIZE, HASH_CONST);
+  bench_report("hash32", rounds, get_cur_time_ns() - start);
+
+  /* The metrics channel: shm for local runs, a file for devcloud jobs. */
+
+  start = get_cur_time_ns();
+  for (u64 r = 0; r < rounds; r++) bench_sink += load_metrics("", &m);
+  bench_report("metrics_shm", rounds, get_cur_time_ns() - start);
+
+  std::string dir = std::string(out_dir) + ".bench/";
+
+  if (mkdir(dir.c_str(), 0700) && errno != EEXIST)
+    PFATAL("Unable to create '%s'", dir.c_str());
+
+  save_test_case(dir + METRICS_FILE, std::string((char*)metrics, sizeof(*metrics)));
+
+  start = get_cur_time_ns();
+  for (u64 r = 0; r < rounds; r++) bench_sink += load_metrics(dir, &m);
+  bench_report("metrics_file", rounds, get_cur_time_ns() - start);
+
+  remove_job_dir(dir);
+
+  bench_save();
+
+}
+
 int main(int argc, char** argv) {
 
   SAYF(cCYA "differential-testing-fuzz " cBRI VERSION cRST " by <wangjiyuan@cs.ucla.edu>\n");
 
+  s32 opt;
+  char* app;
+
+  /* -resume is the one option with a long name; the single-letter ones
+     parse as before. */
+
+  static const struct option long_opts[] = {
+    {"resume", no_argument, NULL, OPT_RESUME},
+    {NULL, 0, NULL, 0}
+  };
+
   memset(in_dir, 0, 256);
   memset(out_dir, 0, 256);
-  
-  if(argc < 5)  usage(argv[0]);
 
-  memcpy(in_dir, argv[1], strlen(argv[1]));
-  memcpy(out_dir, argv[2], strlen(argv[2]));
-  max_trials = atoi(argv[3]);
+  while ((opt = getopt_long_only(argc, argv, "+FD:E:KdXPxj:N:G:M:S:b:BU:R:s:r:V:t:",
+                                 long_opts, NULL)) > 0)
+
+    switch (opt) {
+
+      case 'F': /* fork server */
+
+        forkserver_mode = 1;
+
+        /* The fork server only makes sense for a target we exec locally. */
+
+        devcloud_fpga_enable = 0;
+        devcloud_fpga_hd_enable = 0;
+        devcloud_gpu_enable = 0;
+        break;
+
+      case 'D': /* local backends */
+
+        if (backend_list) FATAL("Multiple -D options not supported");
+        backend_list = optarg;
+
+        /* Backends run here, side by side, instead of as qsub jobs. */
+
+        devcloud_fpga_enable = 0;
+        devcloud_fpga_hd_enable = 0;
+        devcloud_gpu_enable = 0;
+        break;
+
+      case OPT_RESUME: /* resume from a checkpoint */
+
+        resume_mode = 1;
+        break;
+
+      case 't': /* timeout */
+
+        if (tmout_given) FATAL("Multiple -t options not supported");
+        if (sscanf(optarg, "%u", &exec_tmout) < 1 || !exec_tmout)
+          FATAL("Bad syntax used for -t");
+        tmout_given = 1;
+        break;
+
+      case 'E': /* filter exploration rate */
+
+        if (sscanf(optarg, "%lf", &explore_rate) < 1 || explore_rate < 0 ||
+            explore_rate > 1) FATAL("Bad syntax used for -E");
+        break;
+
+      case 'P': /* packed corpus */
+
+        packed_corpus = 1;
+        break;
+
+      case 'x': /* export the packed corpus */
+
+        export_mode = 1;
+        break;
+
+      case 'X': /* self-benchmark */
+
+        bench_mode = 1;
+        break;
+
+      case 'd': /* debug logging */
+
+        debug_mode = 1;
+        break;
+
+      case 'K': /* key test cases by value */
+
+        canonical_keys = 1;
+        break;
+
+      case 'j': /* devcloud jobs in flight */
+
+        max_hw_jobs = atoi(optarg);
+        if (!max_hw_jobs) FATAL("Bad value for -j");
+        break;
+
+      case 'N': /* FPGA node pool */
+
+        fpga_node_list = optarg;
+        break;
+
+      case 'G': /* GPU node pool */
+
+        gpu_node_list = optarg;
+        break;
+
+      case 'U': /* ULP tolerance */
+
+        if (sscanf(optarg, "%u", &max_ulps) < 1) FATAL("Bad syntax used for -U");
+        break;
+
+      case 'R': /* relative tolerance */
+
+        if (sscanf(optarg, "%lf", &max_rel_err) < 1 || max_rel_err < 0)
+          FATAL("Bad syntax used for -R");
+        break;
+
+      case 's': /* RNG seed */
+
+        if (sscanf(optarg, "%llu", &rng_seed) < 1) FATAL("Bad syntax used for -s");
+        rng_seed_set = 1;
+        break;
+
+      case 'r': { /* regenerate */
+
+        long long id;
+
+        if (sscanf(optarg, "%lld", &id) < 1 || id < 0)
+          FATAL("Bad syntax used for -r");
+        replay_id = id;
+        break;
+
+      }
+
+      case 'V': /* kernel variants */
+
+        if (sscanf(optarg, "%u", &num_variants) < 1 || !num_variants ||
+            num_variants > MAX_VARIANTS) FATAL("Bad value for -V");
+        break;
+
+      case 'B': /* binary test cases */
+
+        binary_inputs = 1;
+        break;
+
+      case 'M': /* main sync ID */
+
+        if (sync_id) FATAL("Multiple -M or -S options not supported");
+        sync_id = optarg;
+        main_worker = 1;
+        break;
+
+      case 'S': /* secondary sync ID */
+
+        if (sync_id) FATAL("Multiple -M or -S options not supported");
+        sync_id = optarg;
+
+        /* N workers must not flood the node pool with N times the
+           hardware jobs; secondaries explore on the local device. */
+
+        devcloud_fpga_enable = 0;
+        devcloud_fpga_hd_enable = 0;
+        devcloud_gpu_enable = 0;
+        break;
+
+      case 'b': /* bind CPU core */
+
+        if (cpu_to_bind != -1) FATAL("Multiple -b options not supported");
+        if (sscanf(optarg, "%d", &cpu_to_bind) < 1 || cpu_to_bind < 0)
+          FATAL("Bad syntax used for -b");
+        break;
+
+      default:
+
+        usage(argv[0]);
+
+    }
+
+  if (argc - optind < 4) usage(argv[0]);
+
+  if (strlen(argv[optind]) >= sizeof(in_dir) ||
+      strlen(argv[optind + 1]) >= sizeof(out_dir))
+    FATAL("Input or output path too long");
+
+  strcpy(in_dir, argv[optind]);
+  strcpy(out_dir, argv[optind + 1]);
+  max_trials = atoi(argv[optind + 2]);
+  app = argv[optind + 3];
+  target_path = app;
 
 
   if (!strcmp(in_dir, out_dir))
     FATAL("Input and output directories can't be the same");
 
+  if (forkserver_mode && backend_list)
+    FATAL("-F and -D are mutually exclusive");
+
+  if (bench_mode && backend_list)
+    FATAL("-X and -D are mutually exclusive");
+
+  if (export_mode) {
+    export_corpus();
+    exit(0);
+  }
+
+  if (replay_id >= 0) {
+    load_queue(in_dir);
+    seed_cnt = input_queue.size();
+    regenerate();
+    exit(0);
+  }
+
+  if (!rng_seed_set) {
+    s32 fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0 || read(fd, &rng_seed, 8) != 8) PFATAL("Unable to read /dev/urandom");
+    close(fd);
+  }
+
+  /* Same -s, different workers: different streams. */
+
+  rng_init(rng_worker, rng_seed ^ (sync_id ? hash32(sync_id, strlen(sync_id), HASH_CONST) : 0));
+  OKF("Random seed: %llu", rng_seed);
+
+  if (sync_id) setup_sync_dir();
+  if (cpu_to_bind != -1) bind_to_cpu();
+  setup_input_fd();
+  if (backend_list) setup_backends(app);
+
 
   setup_shm();
+  setup_signal_handlers();
+  init_count_class16();
   OKF("Shared memory is ready.");
   u32 ck1 = hash32(trace_bits, MAP_SIZE, HASH_CONST);
   SAYF("main cksum %d\n", ck1);
   
-  list_dir(in_dir);
+  load_queue(in_dir);
+  seed_cnt = input_queue.size();
   OKF("Input queue initialized with %d seeds.", input_queue.size());
+
+  if (bench_mode) {
+    mkdir(out_dir, 0700);
+    self_bench(app);
+    exit(0);
+  }
+
+  if (resume_mode && !(resumed = load_state()))
+    WARNF("No checkpoint in '%s', starting over.", out_dir);
+
+  setup_replay_log(resumed ? resume_hdr.replay_end : 0);
+  setup_result_cache();
+  if (packed_corpus)
+    setup_corpus(resumed ? resume_hdr.corpus_data_end : 0,
+                 resumed ? resume_hdr.corpus_index_end : 0);
   // for(int i = 0; i < input_queue.size(); i++){
   //   printf("%s\n", input_queue[i]->fname);
   // }
@@ -865,20 +5868,51 @@ int main(int argc, char** argv) {
   OKF("The start time is: %lld", start_time);
 
  
-  OKF("Perform dry run!");
-  perform_dry_run(argv[4]);
-  
+  /* A checkpoint has the seeds' coverage and timeout already. */
 
-  printf("Fuzzing execution time: %lld\n", end_time-start_time);
+  if (!resumed) {
+    OKF("Perform dry run!");
+    perform_dry_run(app);
+    set_exec_timeout();
+    OKF("The binary works well with the seed input.");
+  }
 
-  OKF("The binary works well with the seed input.");
-  
+
+  if (forkserver_mode) init_forkserver(app);
+  if (devcloud_jobs()) setup_hw_nodes();
 
   OKF("Start fuzzing!");
-  fuzzing(argv[4], max_trials);
+  telem_start();
+  if (resumed) import_lost_finds(app);
+  fuzzing(app, max_trials);
+  telem_stop();
+
+  save_state();
+  if (stop_soon) OKF("Stopped at iteration %d, resume with -resume.", fuzz_iter);
 
   end_time = get_cur_time();
   OKF("The end time is: %lld\n", end_time);
+  OKF("Skipped %llu repeated test cases and %llu clones.", skipped_inputs,
+      skipped_clones);
+  OKF("Hangs: %u kept, %llu more with a known trace.",
+      telem_hangs.load(std::memory_order_relaxed), skipped_hangs);
+  OKF("Result cache: %llu hits, %u results.", cache_hits, (u32)cache_index.size());
+  OKF("Reached %u hardware buckets, %u hardware cells.", hw_buckets_hit,
+      (u32)hw_elites.size());
+  OKF("Calibration turned down %u slowdowns as noise.", slow_rejected);
+  OKF("Queue: %u entries, %u favored, %llu cycles.", (u32)input_queue.size(),
+      queued_favored, queue_cycle);
+  if (filter_runs)
+    OKF("Filter: %llu expensive runs, %llu finds, %llu turned down, %llu explored.",
+        filter_runs, filter_finds, filter_skipped, filter_explored);
+  show_arms("Host", host_arms, HOST_ARMS);
+  show_arms("Device", dev_arms, DEV_ARMS);
+  if (num_variants) show_arms("Variant", var_arms, num_variants);
+
+  /* A persistent child may still be parked in SIGSTOP. */
+
+  if (child_pid > 0) kill(child_pid, SIGKILL);
+  if (forksrv_pid > 0) kill(forksrv_pid, SIGKILL);
 
   OKF("We're done here. Have a nice day!\n");
 